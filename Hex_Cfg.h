@@ -41,6 +41,119 @@
 #endif
 
 #define OPT_GPPLAYER
+#define cGP_QUERYINTERVAL   20      // ms between status queries while a GP sequence plays
+#define cGP_REPLYTIMEOUT    10      // ms to wait for the status, no reply ends the sequence
+#define cGP_NUMSEQS         8       // sequences 0..7 are looked up in the SSC-32 after startup (max 8)
+#define cGP_SCANIDLE        100     // ms without a frame before the next sequence is looked up
+
+//uncomment to solve atan2/hypot (and acos) with CORDIC shift-add iterations instead of
+//isqrt32, a divide and the ArcCos table.  More iterations are more accurate but slower.
+//#define OPT_CORDIC_ATAN2
+#ifndef cCORDIC_ITERATIONS
+#define cCORDIC_ITERATIONS  14      // 8..16
+#endif
+
+//uncomment to have the compiler build the sin and arccos tables (Hex_Trig.h) for the steps
+//below instead of using the tables in the sketch: finer steps cost flash and buy accuracy.
+//The build fails when a lookup can be off by more than the max errors.  With OPT_TRIGINTERP
+//the lookups interpolate between the entries.
+//#define OPT_TRIGTABLES
+//#define OPT_TRIGINTERP
+#define cTRIG_SINSTEP1      5       // sin table step in 0.1 deg, divides 900 (5: 181 entries)
+#define cTRIG_ACOSSTEP0     79      // arccos table steps in cos 1e-4: below 0.9,
+#define cTRIG_ACOSSTEP1     8       // 0.9 to 0.99
+#define cTRIG_ACOSSTEP2     2       // and 0.99 to 1, divides 100 (79, 8, 2: 278 entries)
+#define cTRIG_ACOSBITS      8       // 8: byte entries of PI/2/255, 16: word entries in 1e-4 rad
+#define cTRIG_SINMAXERR4    90      // largest error allowed, 1e-4
+#define cTRIG_ACOSMAXERR4   190     // largest error allowed, 1e-4 rad
+
+//uncomment to do the body rotation (BodyFK) and the radian to degree conversions of LegIK and
+//the balance in binary fixed point (Hex_Fixed.h): sin/cos get 14 fraction bits and scaling is
+//a shift instead of a divide by 10000 or 100.  "hexbench -m" checks it against the decimal math.
+//#define OPT_FIXEDPOINT
+
+//uncomment to interpolate the femur and tibia angles from a table over the leg workspace
+//(Hex_IKTable.h, "make -C host iktable" builds it) instead of solving them, 3DOF only
+//#define OPT_IKTABLE
+
+//uncomment to have the compiler make the leg by leg steps of loop() (balance, BodyFK/LegIK,
+//CheckAngles and the servo output) once per leg from the leg constants above (Hex_Robot.h):
+//no PROGMEM lookups, left/right flips or 3/4DOF tests at run time.  Same angles, more flash.
+//#define OPT_LEGTEMPLATES
+
+//uncomment to run the gait on time instead of one step per loop: the walking speed no longer
+//depends on the loop rate and the legs move part of a step when the loop is faster than a step
+//#define OPT_GAITPHASE
+#ifndef cGAITPHASE_MAXSTEPS
+#define cGAITPHASE_MAXSTEPS 2       // most steps one (slow) loop may advance the gait
+#endif
+
+//uncomment to stream a short frame every cSTREAM_PERIOD ms while walking instead of one group
+//move per gait step.  The gait runs on time (turns on OPT_GAITPHASE), so the feet follow it
+//between its steps instead of the straight line the SSC-32 takes, and input shows up in the
+//next frame.  Needs the scheduler.  The frames have to fit the link: "make bench" shows the
+//rate it can take (ASCII frames at 38400 baud do not fit in 20 ms).
+//#define OPT_STREAMING
+#define cSTREAM_PERIOD      20      // ms per frame while walking
+#ifdef OPT_STREAMING
+#define OPT_GAITPHASE
+#endif
+
+//comment to pace the loop the old way, by waiting after each cycle.  The scheduler starts the
+//cycles at fixed times: walking every NomGaitSpeed ms (or the servo move time when that is
+//shorter), otherwise every cSCHED_PERIOD ms.  It counts late cycles and how late ("T" in the
+//terminal monitor).
+#define OPT_SCHEDULER
+#define cSCHED_PERIOD       20      // ms between cycles when not walking
+
+//uncomment to stop working while nothing changes.  After cIDLE_CYCLES cycles in which the input
+//(g_InControlState) stayed the same and the gait did not move, the loop only reads the input
+//every cIDLE_PERIOD ms: no gait, IK or servo frames, the SSC-32 link is free.  The first read
+//that sees a change runs a whole cycle.  Every cIDLE_KEEPALIVE ms (0: never) one cycle runs
+//anyway and sends all servos (or frees them again when off).
+//#define OPT_IDLE
+#define cIDLE_CYCLES        25      // cycles without a change before idling (max 255)
+#define cIDLE_PERIOD        60      // ms between input reads while idle
+#define cIDLE_KEEPALIVE     0       // ms between whole cycles while idle, 0 = none
+
+//uncomment to queue the sounds instead of MSound waiting until they are done.  With the queue
+//MSound returns at once and the notes play in the background.  On AVR that uses Timer2, so
+//there is no PWM on pins 3 and 11.  The Timer2 code has not been built and heard on a board yet.
+//#define OPT_SOUNDQUEUE
+#define cSOUND_QUEUE        8       // notes, one less fit in; more are dropped
+
+//uncomment to give each frame the shortest move time the servos can do its largest pulse
+//change in at cSERVO_MAXSPEED.  The time from the gait speed and the sticks (sneaking) stays
+//the longest a move may take; walking moves are not shorter than NomGaitSpeed.
+//#define OPT_ADAPTIVE_MOVETIME
+#define cSERVO_MAXSPEED     200     // degrees per second the servos manage under load
+#define cMOVETIME_MIN       20      // ms, shortest move when not walking
+
+//uncomment to cache the balance instead of working it out for all six legs every cycle.  With
+//the cache a leg's part of the balance is only worked out again when its position changed, and
+//the body only when a leg's part did, standing still costs next to nothing.  The result is the
+//same; it takes about 90 bytes of RAM.
+//#define OPT_BALANCE_CACHE
+
+//uncomment to cache BodyFK and LegIK instead of working them out for all six legs every cycle.
+//With the cache a leg is only worked out again when the position BodyFK gets for it, its gait
+//rotation or the body rotation changed; otherwise it keeps its angles, and the servo driver
+//the pulses of them.  The result is the same; it takes about 160 bytes of RAM (90 for the
+//legs and the body, 72 in the servo driver).  "P" in the terminal monitor shows how many legs
+//were reused.
+//#define OPT_IK_CACHE
+
+//uncomment to get the balance angles from an atan2 without the hypotenuse (a fit that is
+//within 0.3 degrees, closer than GetATan2 with the ArcCos table) instead of GetATan2
+//#define OPT_BALANCE_FASTATAN
+
+//Walking moves are made this much longer in balance mode, so they run into each other.  The
+//steps still come every NomGaitSpeed ms; it is not time for the balance math, that is small.
+#define cBALANCE_MOVETIME   100     // ms
+
+//uncomment to time the stages of each cycle with micros(), "P" in the terminal monitor shows
+//min/avg/max per stage
+//#define OPT_PROFILE
 
 // Which type of control(s) do you want to compile in
 #define DBGSerial         Serial
@@ -59,13 +172,24 @@
 //==================================================================================================================================
 #define USE_SSC32
 //#define	cSSC_BINARYMODE	1			// Define if your SSC-32 card supports binary mode.
+#define OPT_SSC_DELTAUPDATES        // Only send the servos whose pulse changed since the last frame
+#define cSSC_FULLREFRESH    32      // but still send all of them every this many frames
+//uncomment to send the servo frames in the background while the next one is computed.  Costs a
+//second frame buffer (233 bytes of RAM), and on boards without a hardware UART for the SSC-32
+//the frames go out through a Timer1 soft UART; neither has been checked on an AVR build yet.
+//#define OPT_SSC_ASYNCTX
+//#define OPT_SSC_MOVESYNC          // Ask the SSC-32 when the move is done ("Q") instead of waiting out the move time
+#define cSSC_MOVELEAD       0       // or let the next frame go this many ms before the planned end, without asking
+#define cSSC_MOVEQINTERVAL  2       // ms between "Q" queries once the move should be done
 
 //[SERIAL CONNECTIONS]
 
 // Warning I will undefine some components as the non-megas don't have enough memory...
 //#undef OPT_FIND_SERVO_OFFSETS
 
+#ifndef cSSC_BAUD
 #define cSSC_BAUD   38400   //SSC32 BAUD rate
+#endif
 
 //--------------------------------------------------------------------
 //[Botboarduino Pin Numbers]
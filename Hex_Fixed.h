@@ -0,0 +1,105 @@
+//==============================================================================
+// Hex_Fixed.h - Binary fixed point numbers for the body and leg math (OPT_FIXEDPOINT).
+//
+// A QNUM<F, T> is a number times 2^F, held in the integer type T.  The number
+// of fraction bits is part of the type: a multiply gives a long with the bits
+// of both, and To<F2>() or Mul() get back to the bits wanted with a shift.
+// So where the decimal math divides by c4DEC or c2DEC to get back to its
+// scale, this shifts, and the compiler works out by how much.
+//
+// With QNUM_CHECK defined (the host build does) every result that does not
+// fit its type is counted in g_cQNumOverflows; on the AVR the checks are not
+// there.
+//==============================================================================
+#ifndef _HEX_FIXED_H_
+#define _HEX_FIXED_H_
+
+#ifdef QNUM_CHECK
+extern unsigned long g_cQNumOverflows;
+#define QNUM_CHECKFIT(ll, T)    do { if ((long long)(ll) != (long long)(T)(ll)) g_cQNumOverflows++; } while (0)
+#else
+#define QNUM_CHECKFIT(ll, T)
+#endif
+
+// l times 2^D: a multiply to the left, a rounded shift to the right
+template <int D, bool fLeft = (D >= 0)> struct QSHIFT {
+    static long Do(long l) {return l * (1L << D);}
+};
+template <int D> struct QSHIFT<D, false> {
+    static long Do(long l) {return (l + (1L << (-D - 1))) >> -D;}
+};
+
+// l clipped to what a T can hold
+template <typename T> inline T QSat(long l)
+{
+    const long lMax = (long)((1UL << (sizeof(T)*8 - 1)) - 1);
+    if (l > lMax)
+        return (T)lMax;
+    if (l < -lMax - 1)
+        return (T)(-lMax - 1);
+    return (T)l;
+}
+
+template <int F, typename T = long> class QNUM {
+  public:
+    T       raw;                    // the number times 2^F
+
+    static QNUM Raw(T r) {QNUM q; q.raw = r; return q;}
+    static QNUM Int(long l)
+    {
+        QNUM_CHECKFIT((long long)l << F, T);
+        return Raw((T)QSHIFT<F>::Do(l));
+    }
+
+    // Rounded to the nearest integer
+    long ToInt(void) const {return QSHIFT<-F>::Do(raw);}
+
+    // The same number with F2 fraction bits in a T2, rounded when bits are dropped
+    template <int F2, typename T2> QNUM<F2, T2> To(void) const
+    {
+        long l = QSHIFT<F2 - F>::Do(raw);
+        QNUM_CHECKFIT(l, T2);
+        return QNUM<F2, T2>::Raw((T2)l);
+    }
+    template <int F2> QNUM<F2, T> To(void) const {return To<F2, T>();}
+
+    // As To, but clipped to what a T2 can hold instead of wrapping
+    template <int F2, typename T2> QNUM<F2, T2> Sat(void) const
+    {
+        return QNUM<F2, T2>::Raw(QSat<T2>(QSHIFT<F2 - F>::Do(raw)));
+    }
+
+    // Widening multiply: the fraction bits add up, in a long
+    template <int F2, typename T2> QNUM<F + F2, long> operator* (QNUM<F2, T2> q) const
+    {
+        QNUM_CHECKFIT((long long)raw * q.raw, long);
+        return QNUM<F + F2, long>::Raw((long)raw * q.raw);
+    }
+
+    // Multiply that keeps this number's format, for factors like sin and cos
+    template <int F2, typename T2> QNUM Mul(QNUM<F2, T2> q) const
+    {
+        return (*this * q).template To<F, T>();
+    }
+
+    QNUM operator+ (QNUM q) const
+    {
+        QNUM_CHECKFIT((long long)raw + q.raw, T);
+        return Raw(raw + q.raw);
+    }
+    QNUM operator- (QNUM q) const
+    {
+        QNUM_CHECKFIT((long long)raw - q.raw, T);
+        return Raw(raw - q.raw);
+    }
+    QNUM operator- (void) const {return Raw(-raw);}
+    bool operator== (QNUM q) const {return raw == q.raw;}
+    bool operator!= (QNUM q) const {return raw != q.raw;}
+};
+
+// Formats the sketch uses
+typedef QNUM<14, short> QSIN;       // sin and cos from GetSinCos, 16384 = 1
+typedef QNUM<6, long>   QPOS;       // mm, in 1/64 mm: room for sin * cos * sin of 500 mm
+typedef QNUM<0, long>   QINT;
+
+#endif //_HEX_FIXED_H_
@@ -35,10 +35,210 @@
 
 
 
-#define NUM_GAITS    4
+//-----------------------------------------------------------------------------
+// Results of the fixed point trig and IK functions.  They are returned by
+// value instead of being left in globals, so the functions can be called
+// from anywhere without stepping on each other.
+//-----------------------------------------------------------------------------
+#ifdef OPT_FIXEDPOINT
+#define cSINCOS_ONE         16384   // sin/cos have 14 fraction bits (QSIN in Hex_Fixed.h)
+#else
+#define cSINCOS_ONE         c4DEC
+#endif
+typedef struct _SinCos {
+    short       sin4;               // Sinus of the angle, times cSINCOS_ONE
+    short       cos4;               // Cosinus of the angle, times cSINCOS_ONE
+} SINCOS;
+
+typedef struct _ATan2 {
+    short       atan4;              // ArcTan2 in radians, decimals = 4
+    short       hyp2;               // Hypotenuse of X and Y, decimals = 2
+} ATAN2;
+
+// Constants of the leg IK, built by InitLegIKConst from the leg lengths in
+// Hex_Cfg.h so LegIK does not read and multiply them for every leg.
+typedef struct _LegIKConst {
+    long        FTDiff4;            // femur^2 - tibia^2, decimals = 4
+    long        FTSum4;             // femur^2 + tibia^2, decimals = 4
+    word        TwoFemur2;          // 2 * femur, decimals = 2
+    word        TwoFemurTibia;      // 2 * femur * tibia
+    word        ReachOK2;           // shoulder-wrist lengths below this are fine, decimals = 2
+    word        Reach2;             // and below this nearly possible, decimals = 2
+    short       CoxaAngle1;         // Default leg angle, decimals = 1
+    short       FemurHornOffset1;
+    byte        CoxaLength;
+#ifdef c4DOF
+    byte        TarsLength;         // 0 for a 3DOF leg
+    short       TarsHornOffset1;
+#endif
+} LEGIKCONST;
+
+// Sinus and cosinus of the body rotation for BodyFK, see BodyRotUpdate.  X
+// (pitch) and Z (roll) are the same for all legs; the Y rotation of each leg
+// has its gait rotation added, the last one is kept.
+typedef struct _BodyRot {
+    short       RotX1;              // Angles the sin/cos are for, decimals = 1
+    short       RotZ1;
+    long        RotY1;              // Body Y rotation, without the gait rotation
+    SINCOS      G;                  // X rotation
+    SINCOS      B;                  // Z rotation
+    boolean     fNoTilt;            // X and Z rotation are both zero
+    short       LegRotY1;           // Y rotation of the last leg
+    SINCOS      A;                  // Y rotation of the last leg
+} BODYROT;
+
+#define cIKSolution         0       // The solution is possible
+#define cIKSolutionWarning  1       // The solution is NEARLY possible
+#define cIKSolutionError    2       // The solution is NOT possible
+
+typedef struct _LegIKSolution {
+    short       CoxaAngle1;         // decimals = 1
+    short       FemurAngle1;
+    short       TibiaAngle1;
+#ifdef c4DOF
+    short       TarsAngle1;
+#endif
+    byte        bStatus;            // cIKSolution, cIKSolutionWarning or cIKSolutionError
+} LEGIKSOLUTION;
+
+// Gaits, see GaitDefs.  Every step a leg does one of these actions, which
+// one depends on how many steps ago it was lifted (its phase).
+#define NUM_GAITS           5
+#define cGAITMAXSTEPS       24      // most steps in one gait
+
+#define cGaitPush           0       // on the floor, move the body forward
+#define cGaitUp             1       // lifted all the way, in the middle
+#define cGaitUpHome         2       // not walking: lift if not at home (else push)
+#define cGaitHalfRear       3       // half height, rear
+#define cGaitHalfFront      4       // half height, front
+#define cGaitRear2          5       // 5 lifted positions: outer rear
+#define cGaitFront2         6       // 5 lifted positions: outer front
+#define cGaitDown           7       // put down if still lifted (else push)
+
+typedef struct _GaitDef {
+    byte        LegNr[6];           // step each leg is lifted at (1..StepsInGait), cRR..cLF
+    byte        NrLiftedPos;        // number of positions that a single leg is lifted [1-5]
+    byte        HalfLiftHeigth;     // outer lifted positions: 0 full, 3 half, 1 3/4 height
+    byte        TLDivFactor;        // number of steps that a leg is on the floor
+    byte        StepsInGait;
+    byte        NomGaitSpeed;
+    byte        Phases[cGAITMAXSTEPS];  // action by phase: walking in the low nibble, standing in the high one
+} GAITDEF;
+
 extern void GaitSelect(void);
 extern short SmoothControl (short CtrlMoveInp, short CtrlMoveOut, byte CtrlDivider);
 
+#ifdef OPT_BALANCE_CACHE
+// A leg's part of the balance only depends on the position BalCalcOneLeg gets for it,
+// so it is kept until that changes.
+typedef struct _BalLeg {
+    short       PosX;               // position the part is for
+    short       PosZ;
+    short       PosY;
+    short       YBal1;              // angles, decimals = 1
+    short       ZBal1;
+    short       XBal1;
+    boolean     fValid;
+} BALLEG;
+
+// What BalanceBody made of the totals, for when no leg's part changed
+typedef struct _BalBody {
+    short       TransX;
+    short       TransZ;
+    short       TransY;
+    short       XBal1;
+    short       YBal1;
+    short       ZBal1;
+} BALBODY;
+#endif
+
+#ifdef OPT_IK_CACHE
+// A leg's angles only depend on the position BodyFK gets for it, its gait rotation
+// and the body (IKCACHEBODY), so they are kept until one of them changes.
+typedef struct _IKCacheLeg {
+    short       PosX;               // BodyFK input the angles are for
+    short       PosZ;
+    short       PosY;
+    short       RotY;               // gait rotation
+    byte        bStatus;            // of the IK solution
+    boolean     fValid;
+    boolean     fHit;               // this cycle kept the angles
+} IKCACHELEG;
+
+// What is the same for all legs
+typedef struct _IKCacheBody {
+    short       RotX1;              // body rotation, with balance
+    short       RotZ1;
+    long        RotY1;
+    short       BodyPosX;           // the left legs' LegIK gets it on its own
+    short       RotOffsetX;         // BodyRotOffset
+    short       RotOffsetY;
+    short       RotOffsetZ;
+} IKCACHEBODY;
+
+extern unsigned long    g_cIKCacheLegs;     // legs through FK/IK since the last ProfReset
+extern unsigned long    g_cIKCacheHits;     // of them, kept their angles
+#endif
+
+#ifdef OPT_SCHEDULER
+// Scheduler statistics, see SchedWait
+#define cSCHED_LATEBUCKETS  8       // start of the cycle after its deadline: <64us, <128us ... <4ms, >=4ms
+typedef struct _SchedStats {
+    unsigned long   cCycles;
+    unsigned long   cMissed;        // cycles that were not done by their deadline
+    unsigned long   ulMaxLate;      // us, latest start of a cycle
+    word            awLate[cSCHED_LATEBUCKETS];  // cycles by how late they started (stops at 65535)
+} SCHEDSTATS;
+
+extern SCHEDSTATS       g_SchedStats;
+extern void SchedStart(void);
+extern void SchedWait(word wPeriod, boolean fMoveSync);
+#endif
+
+#ifdef OPT_IDLE
+extern unsigned long    g_cIdleCycles;      // cycles that only read the input, see FIdleCycle
+extern unsigned long    g_cIdleWakes;       // times a change ended the idling
+#endif
+
+// Time of the stages of a cycle, see ProfEnd.  PROF_BEGIN/PROF_END go around a stage,
+// PROF_ADD adds a time measured some other way; all are nothing without OPT_PROFILE.
+#ifdef OPT_PROFILE
+#define cPROF_VOLTAGE       0       // CheckVoltage
+#define cPROF_INPUT         1       // ControlInput
+#define cPROF_GPPLAYER      2
+#define cPROF_SINGLELEG     3       // SingleLegControl
+#define cPROF_GAIT          4       // GaitSeq
+#define cPROF_BALANCE       5
+#define cPROF_IK            6       // BodyFK and LegIK of all legs
+#define cPROF_ANGLES        7       // CheckAngles
+#define cPROF_SERVOS        8       // StartUpdateServos
+#define cPROF_COMMIT        9       // CommitServoDriver
+#define cPROF_MOVEWAIT      10      // waiting for the SSC-32 to finish the move (OPT_SSC_MOVESYNC)
+#define cPROF_MOVESAVED     11      // of the wait the move time asked for, what was left when it was done
+#define NUM_PROFSTAGES      12
+
+typedef struct _ProfStage {
+    word            cCalls;         // stops counting at 65535
+    word            wMin;           // us
+    word            wMax;           // us, 65535 or more
+    unsigned long   ulSum;          // us
+} PROFSTAGE;
+
+extern PROFSTAGE        g_aProfStages[NUM_PROFSTAGES];
+extern unsigned long    g_ulProfStart;
+extern void ProfEnd(byte iStage);
+extern void ProfAdd(byte iStage, unsigned long ulTime);
+extern void ProfReset(void);
+
+#define PROF_BEGIN()        (g_ulProfStart = micros())
+#define PROF_END(iStage)    ProfEnd(iStage)
+#define PROF_ADD(iStage, ulTime)    ProfAdd(iStage, ulTime)
+#else
+#define PROF_BEGIN()
+#define PROF_END(iStage)
+#define PROF_ADD(iStage, ulTime)
+#endif
+
 
 //-----------------------------------------------------------------------------
 // Define global class objects
@@ -93,6 +293,10 @@ extern word			SpeedControl;	//Adjustible Delay
 
 
 extern void MSound(uint8_t _pin, byte cNotes, ...);
+#ifdef OPT_SOUNDQUEUE
+extern void SoundService(void);                 // plays the queued notes where there is no timer for it
+extern byte g_cSoundDropped;
+#endif
 //extern int DBGPrintf(const char *format, ...);
 //extern int SSCPrintf(const char *format, ...);
 
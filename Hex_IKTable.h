@@ -0,0 +1,52 @@
+//==============================================================================
+// Hex_IKTable.h - Femur and tibia angles over the leg workspace (OPT_IKTABLE).
+//
+// Generated by host/ikgen for femur 80 mm, tibia 118 mm and a 8 mm grid,
+// 26 x 34 points, 3536 bytes.  Do not edit, run "make -C host iktable".
+//==============================================================================
+#define cIKTAB_FEMUR        80
+#define cIKTAB_TIBIA        118
+#define cIKTAB_STEPSHIFT    3           // grid step 8 mm
+#define cIKTAB_DMIN         0
+#define cIKTAB_ND           26
+#define cIKTAB_YMIN         -64
+#define cIKTAB_NY           34
+#define cIKTAB_MINR2        2500L      // (|femur - tibia| + 1.5 steps)^2, mm
+
+//{900 - femur, tibia} in degrees, decimals = 1, without horn offsets; by Y then XZ
+static const short GetIKTable[cIKTAB_NY*cIKTAB_ND][2] PROGMEM = {
+    {2896,-593}, {2819,-589}, {2735,-578}, {2646,-560}, {2556,-536}, {2467,-508}, {2382,-475}, {2300,-439}, {2224,-400}, {2151,-358}, {2082,-314}, {2017,-267}, {1954,-218}, {1894,-167}, {1835,-113}, {1778,-56}, {1721,5}, {1664,69}, {1606,138}, {1546,214}, {1483,298}, {1413,394}, {1331,514}, {1217,690}, {1084,900}, {1077,900},
+    {2993,-656}, {2904,-651}, {2804,-637}, {2698,-616}, {2593,-589}, {2491,-557}, {2396,-520}, {2307,-481}, {2224,-439}, {2147,-395}, {2076,-348}, {2009,-300}, {1945,-250}, {1884,-197}, {1825,-142}, {1768,-85}, {1712,-24}, {1655,40}, {1599,108}, {1540,183}, {1478,265}, {1412,358}, {1335,469}, {1237,620}, {1063,900}, {1056,900},
+    {3128,-726}, {3020,-720}, {2894,-702}, {2762,-675}, {2633,-642}, {2514,-604}, {2406,-563}, {2308,-520}, {2219,-475}, {2138,-428}, {2064,-380}, {1996,-330}, {1931,-278}, {1870,-224}, {1811,-169}, {1754,-111}, {1699,-50}, {1643,14}, {1587,83}, {1530,156}, {1470,237}, {1406,327}, {1333,433}, {1244,570}, {1061,865}, {1035,900},
+    {3378,-826}, {3226,-812}, {3035,-780}, {2848,-740}, {2681,-696}, {2535,-651}, {2410,-604}, {2302,-557}, {2207,-508}, {2123,-458}, {2047,-407}, {1977,-356}, {1912,-302}, {1851,-248}, {1793,-191}, {1737,-132}, {1682,-71}, {1627,-7}, {1572,61}, {1517,134}, {1458,214}, {1396,302}, {1326,405}, {1243,533}, {1114,739}, {1013,900},
+    {3600,-900}, {3460,-900}, {3334,-900}, {3009,-826}, {2741,-755}, {2554,-696}, {2407,-642}, {2288,-589}, {2187,-536}, {2100,-484}, {2022,-431}, {1952,-377}, {1888,-323}, {1827,-267}, {1770,-210}, {1715,-150}, {1661,-89}, {1608,-24}, {1554,44}, {1500,116}, {1443,195}, {1382,282}, {1315,382}, {1236,504}, {1123,685}, {991,900},
+    {3600,-900}, {3416,-900}, {3263,-900}, {3150,-900}, {2846,-826}, {2567,-740}, {2393,-675}, {2262,-616}, {2157,-560}, {2068,-505}, {1990,-450}, {1921,-395}, {1858,-339}, {1799,-282}, {1743,-224}, {1689,-165}, {1637,-103}, {1585,-38}, {1533,30}, {1480,102}, {1424,181}, {1365,267}, {1300,365}, {1224,484}, {1120,650}, {968,900},
+    {3600,-900}, {3334,-900}, {3150,-900}, {3037,-900}, {2966,-900}, {2571,-780}, {2363,-702}, {2223,-637}, {2115,-578}, {2027,-520}, {1951,-464}, {1884,-407}, {1823,-351}, {1766,-293}, {1712,-235}, {1660,-175}, {1609,-113}, {1559,-48}, {1508,20}, {1457,93}, {1403,170}, {1345,256}, {1282,353}, {1208,469}, {1110,628}, {946,900},
+    {3600,-900}, {3150,-900}, {2966,-900}, {2884,-900}, {2840,-900}, {2552,-812}, {2309,-720}, {2167,-651}, {2061,-589}, {1977,-530}, {1904,-472}, {1840,-415}, {1782,-358}, {1728,-300}, {1676,-241}, {1627,-181}, {1578,-118}, {1529,-54}, {1481,14}, {1430,87}, {1378,164}, {1322,249}, {1261,346}, {1189,461}, {1094,616}, {923,900},
+    {1800,-900}, {2700,-900}, {2700,-900}, {2700,-900}, {2700,-900}, {2478,-826}, {2228,-726}, {2093,-656}, {1996,-593}, {1917,-533}, {1850,-475}, {1791,-418}, {1737,-360}, {1686,-302}, {1637,-243}, {1590,-183}, {1544,-120}, {1497,-56}, {1450,13}, {1402,85}, {1351,162}, {1296,247}, {1236,343}, {1166,458}, {1072,612}, {900,900},
+    {1800,-900}, {2250,-900}, {2434,-900}, {2516,-900}, {2560,-900}, {2326,-812}, {2120,-720}, {2004,-651}, {1919,-589}, {1850,-530}, {1790,-472}, {1737,-415}, {1687,-358}, {1640,-300}, {1595,-241}, {1550,-181}, {1506,-118}, {1462,-54}, {1417,14}, {1370,87}, {1321,164}, {1268,249}, {1209,346}, {1139,461}, {1046,616}, {877,900},
+    {1800,-900}, {2066,-900}, {2250,-900}, {2363,-900}, {2434,-900}, {2135,-780}, {1994,-702}, {1904,-637}, {1835,-578}, {1776,-520}, {1725,-464}, {1678,-407}, {1634,-351}, {1591,-293}, {1549,-235}, {1508,-175}, {1467,-113}, {1425,-48}, {1381,20}, {1336,93}, {1288,170}, {1237,256}, {1178,353}, {1109,469}, {1015,628}, {854,900},
+    {1800,-900}, {1984,-900}, {2137,-900}, {2250,-900}, {2109,-826}, {1948,-740}, {1862,-675}, {1798,-616}, {1746,-560}, {1699,-505}, {1657,-450}, {1616,-395}, {1577,-339}, {1539,-282}, {1501,-224}, {1463,-165}, {1425,-103}, {1385,-38}, {1344,30}, {1300,102}, {1254,181}, {1203,267}, {1145,365}, {1076,484}, {978,650}, {832,900},
+    {1800,-900}, {1940,-900}, {2066,-900}, {1946,-826}, {1841,-755}, {1781,-696}, {1733,-642}, {1693,-589}, {1656,-536}, {1620,-484}, {1586,-431}, {1553,-377}, {1519,-323}, {1485,-267}, {1451,-210}, {1416,-150}, {1380,-89}, {1343,-24}, {1304,44}, {1262,116}, {1217,195}, {1167,282}, {1109,382}, {1039,504}, {934,685}, {809,900},
+    {1578,-826}, {1652,-812}, {1671,-780}, {1667,-740}, {1654,-696}, {1635,-651}, {1614,-604}, {1591,-557}, {1567,-508}, {1542,-458}, {1515,-407}, {1488,-356}, {1460,-302}, {1430,-248}, {1400,-191}, {1368,-132}, {1335,-71}, {1299,-7}, {1262,61}, {1222,134}, {1177,214}, {1128,302}, {1070,405}, {997,533}, {878,739}, {787,900},
+    {1328,-726}, {1409,-720}, {1463,-702}, {1493,-675}, {1507,-642}, {1510,-604}, {1506,-563}, {1496,-520}, {1482,-475}, {1465,-428}, {1445,-380}, {1423,-330}, {1400,-278}, {1374,-224}, {1347,-169}, {1318,-111}, {1288,-50}, {1254,14}, {1219,83}, {1179,156}, {1136,237}, {1087,327}, {1028,433}, {951,570}, {781,865}, {765,900},
+    {1193,-656}, {1267,-651}, {1323,-637}, {1362,-616}, {1388,-589}, {1402,-557}, {1408,-520}, {1407,-481}, {1400,-439}, {1390,-395}, {1376,-348}, {1359,-300}, {1340,-250}, {1318,-197}, {1294,-142}, {1268,-85}, {1239,-24}, {1208,40}, {1174,108}, {1135,183}, {1093,265}, {1043,358}, {982,469}, {898,620}, {737,900}, {744,900},
+    {1096,-593}, {1161,-589}, {1215,-578}, {1257,-560}, {1287,-536}, {1307,-508}, {1319,-475}, {1324,-439}, {1324,-400}, {1318,-358}, {1309,-314}, {1296,-267}, {1280,-218}, {1262,-167}, {1240,-113}, {1216,-56}, {1190,5}, {1160,69}, {1127,138}, {1090,214}, {1047,298}, {996,394}, {932,514}, {833,690}, {716,900}, {723,900},
+    {1017,-533}, {1077,-530}, {1127,-520}, {1168,-505}, {1200,-484}, {1223,-458}, {1238,-428}, {1247,-395}, {1251,-358}, {1249,-318}, {1244,-276}, {1234,-231}, {1221,-183}, {1205,-132}, {1186,-79}, {1164,-22}, {1139,38}, {1111,102}, {1079,172}, {1042,249}, {998,336}, {945,439}, {875,570}, {731,824}, {694,900}, {702,900},
+    {950,-475}, {1004,-472}, {1051,-464}, {1090,-450}, {1122,-431}, {1147,-407}, {1164,-380}, {1176,-348}, {1182,-314}, {1184,-276}, {1181,-235}, {1174,-191}, {1163,-144}, {1149,-95}, {1132,-42}, {1112,14}, {1088,75}, {1061,140}, {1029,211}, {991,291}, {947,382}, {890,492}, {807,646}, {665,900}, {674,900}, {682,900},
+    {891,-418}, {940,-415}, {984,-407}, {1021,-395}, {1052,-377}, {1077,-356}, {1096,-330}, {1109,-300}, {1117,-267}, {1120,-231}, {1119,-191}, {1114,-148}, {1106,-103}, {1093,-54}, {1078,-1}, {1059,55}, {1036,116}, {1009,183}, {977,256}, {938,339}, {891,436}, {827,560}, {712,770}, {644,900}, {654,900}, {663,900},
+    {837,-360}, {882,-358}, {923,-351}, {958,-339}, {988,-323}, {1012,-302}, {1031,-278}, {1045,-250}, {1054,-218}, {1059,-183}, {1059,-144}, {1056,-103}, {1049,-58}, {1038,-9}, {1023,44}, {1005,100}, {982,162}, {955,230}, {922,307}, {882,394}, {829,501}, {752,650}, {614,900}, {624,900}, {634,900}, {644,900},
+    {786,-302}, {828,-300}, {866,-293}, {899,-282}, {927,-267}, {951,-248}, {970,-224}, {984,-197}, {994,-167}, {999,-132}, {1001,-95}, {998,-54}, {992,-9}, {982,40}, {968,93}, {950,150}, {927,214}, {899,284}, {864,365}, {820,461}, {758,585}, {627,824}, {594,900}, {605,900}, {616,900}, {625,900},
+    {737,-243}, {776,-241}, {812,-235}, {843,-224}, {870,-210}, {893,-191}, {911,-169}, {925,-142}, {935,-113}, {941,-79}, {943,-42}, {941,-1}, {935,44}, {925,93}, {911,146}, {893,205}, {870,271}, {840,346}, {802,433}, {750,543}, {665,707}, {563,900}, {575,900}, {587,900}, {597,900}, {608,900},
+    {690,-183}, {727,-181}, {760,-175}, {789,-165}, {815,-150}, {837,-132}, {854,-111}, {868,-85}, {878,-56}, {884,-22}, {886,14}, {884,55}, {878,100}, {868,150}, {853,205}, {834,267}, {809,336}, {776,418}, {732,517}, {663,655}, {531,900}, {545,900}, {557,900}, {569,900}, {580,900}, {590,900},
+    {644,-120}, {678,-118}, {709,-113}, {737,-103}, {761,-89}, {782,-71}, {799,-50}, {812,-24}, {821,5}, {827,38}, {828,75}, {826,116}, {820,162}, {809,214}, {793,271}, {772,336}, {744,412}, {705,504}, {646,628}, {499,900}, {513,900}, {527,900}, {540,900}, {552,900}, {563,900}, {574,900},
+    {597,-56}, {629,-54}, {659,-48}, {685,-38}, {708,-24}, {727,-7}, {743,14}, {755,40}, {764,69}, {769,102}, {770,140}, {767,183}, {759,230}, {747,284}, {729,346}, {705,418}, {670,504}, {617,620}, {466,900}, {482,900}, {496,900}, {510,900}, {523,900}, {535,900}, {547,900}, {558,900},
+    {550,13}, {581,14}, {608,20}, {633,30}, {654,44}, {672,61}, {687,83}, {699,108}, {706,138}, {710,172}, {710,211}, {705,256}, {696,307}, {681,365}, {659,433}, {628,517}, {579,628}, {434,900}, {450,900}, {465,900}, {480,900}, {494,900}, {507,900}, {520,900}, {531,900}, {542,900},
+    {502,85}, {530,87}, {557,93}, {580,102}, {600,116}, {617,134}, {630,156}, {640,183}, {646,214}, {648,249}, {647,291}, {640,339}, {627,394}, {608,461}, {578,543}, {529,655}, {401,900}, {418,900}, {435,900}, {450,900}, {465,900}, {479,900}, {492,900}, {504,900}, {516,900}, {528,900},
+    {451,162}, {478,164}, {503,170}, {524,181}, {543,195}, {558,214}, {570,237}, {578,265}, {583,298}, {583,336}, {578,382}, {567,436}, {549,501}, {519,585}, {465,707}, {369,900}, {387,900}, {404,900}, {420,900}, {435,900}, {450,900}, {464,900}, {477,900}, {490,900}, {502,900}, {513,900},
+    {396,247}, {422,249}, {445,256}, {465,267}, {482,282}, {496,302}, {506,327}, {512,358}, {513,394}, {509,439}, {499,492}, {480,560}, {447,650}, {363,824}, {337,900}, {355,900}, {373,900}, {390,900}, {406,900}, {421,900}, {436,900}, {450,900}, {463,900}, {476,900}, {488,900}, {500,900},
+    {336,343}, {361,346}, {382,353}, {400,365}, {415,382}, {426,405}, {433,433}, {435,469}, {431,514}, {420,570}, {396,646}, {343,770}, {286,900}, {306,900}, {325,900}, {343,900}, {360,900}, {377,900}, {393,900}, {408,900}, {423,900}, {437,900}, {450,900}, {463,900}, {475,900}, {487,900},
+    {266,458}, {289,461}, {308,469}, {324,484}, {336,504}, {343,533}, {344,570}, {337,620}, {317,690}, {259,824}, {235,900}, {256,900}, {276,900}, {295,900}, {313,900}, {331,900}, {348,900}, {365,900}, {380,900}, {396,900}, {410,900}, {424,900}, {437,900}, {450,900}, {462,900}, {474,900},
+    {172,612}, {194,616}, {210,628}, {220,650}, {223,685}, {214,739}, {161,865}, {163,900}, {184,900}, {206,900}, {226,900}, {246,900}, {266,900}, {284,900}, {303,900}, {320,900}, {337,900}, {353,900}, {369,900}, {384,900}, {398,900}, {412,900}, {425,900}, {438,900}, {450,900}, {462,900},
+    {0,900}, {23,900}, {46,900}, {68,900}, {91,900}, {113,900}, {135,900}, {156,900}, {177,900}, {198,900}, {218,900}, {237,900}, {256,900}, {275,900}, {292,900}, {310,900}, {326,900}, {342,900}, {358,900}, {372,900}, {387,900}, {400,900}, {413,900}, {426,900}, {438,900}, {450,900}
+};
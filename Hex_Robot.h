@@ -0,0 +1,65 @@
+//==============================================================================
+// Hex_Robot.h - The legs of Hex_Cfg.h as types (OPT_LEGTEMPLATES).
+//
+// LEGDESC<cRR> .. LEGDESC<cLF> hold the configuration of each leg as
+// compile time constants: which side it is on, where its coxa is, its lengths,
+// limits and pins, and if it has a tars.  Code written as a template on the
+// leg number reads them instead of the PROGMEM tables, so the compiler makes
+// one copy per leg with the constants folded in: the left/right sign flips and
+// the 3DOF/4DOF branches are decided when it is built, not in every loop.
+//
+// The values are enums so they never need storage; cast them to the type the
+// code works in, like the pgm_read_word()s they replace.
+//==============================================================================
+#ifndef _HEX_ROBOT_H_
+#define _HEX_ROBOT_H_
+
+template <byte LEG> struct LEGDESC;
+
+#ifdef c4DOF
+#define LEGDESC_TARS(XX)                                            \
+    enum {                                                          \
+        TarsLength = c##XX##TarsLength,     /* 0: a 3DOF leg */     \
+        TarsMin1 = c##XX##TarsMin1,                                 \
+        TarsMax1 = c##XX##TarsMax1,                                 \
+        TarsPin = c##XX##TarsPin                                    \
+    };
+#else
+#define LEGDESC_TARS(XX)                                            \
+    enum {TarsLength = 0};
+#endif
+
+#define LEGDESC_DEF(LEG, XX, fLEFT)                                 \
+template <> struct LEGDESC<LEG> {                                   \
+    enum {                                                          \
+        fLeft = fLEFT,          /* X is mirrored on the right */    \
+        OffsetX = c##XX##OffsetX,                                   \
+        OffsetZ = c##XX##OffsetZ,                                   \
+        InitPosX = c##XX##InitPosX,                                 \
+        InitPosY = c##XX##InitPosY,                                 \
+        InitPosZ = c##XX##InitPosZ,                                 \
+        CoxaLength = c##XX##CoxaLength,                             \
+        FemurLength = c##XX##FemurLength,                           \
+        TibiaLength = c##XX##TibiaLength,                           \
+        CoxaMin1 = c##XX##CoxaMin1,                                 \
+        CoxaMax1 = c##XX##CoxaMax1,                                 \
+        FemurMin1 = c##XX##FemurMin1,                               \
+        FemurMax1 = c##XX##FemurMax1,                               \
+        TibiaMin1 = c##XX##TibiaMin1,                               \
+        TibiaMax1 = c##XX##TibiaMax1,                               \
+        CoxaPin = c##XX##CoxaPin,                                   \
+        FemurPin = c##XX##FemurPin,                                 \
+        TibiaPin = c##XX##TibiaPin                                  \
+    };                                                              \
+    LEGDESC_TARS(XX)                                                \
+    enum {cServos = TarsLength? 4 : 3};                             \
+};
+
+LEGDESC_DEF(cRR, RR, false)
+LEGDESC_DEF(cRM, RM, false)
+LEGDESC_DEF(cRF, RF, false)
+LEGDESC_DEF(cLR, LR, true)
+LEGDESC_DEF(cLM, LM, true)
+LEGDESC_DEF(cLF, LF, true)
+
+#endif //_HEX_ROBOT_H_
@@ -0,0 +1,189 @@
+//==============================================================================
+// Hex_Trig.h - Sin and ArcCos tables built by the compiler (OPT_TRIGTABLES).
+//
+// The tables GetSinCos and GetArcCos look up in are worked out at compile
+// time for the steps set in Hex_Cfg.h, so a board with flash to spare can
+// have finer ones and a small one coarser ones.  The build checks every
+// lookup the sketch can do against the real function and fails when one is
+// off by more than cTRIG_SINMAXERR4 or cTRIG_ACOSMAXERR4.
+//
+// The lookups are written once, for entries from a "getter": GEN works the
+// entry out (for the checks), PGM reads it from the table in flash.
+//==============================================================================
+#ifndef _HEX_TRIG_H_
+#define _HEX_TRIG_H_
+
+//-----------------------------------------------------------------------------
+// Math the compiler can do
+//-----------------------------------------------------------------------------
+#define TRIG_PI     3.14159265358979
+
+constexpr double TrigAbs(double d) {return (d < 0)? -d : d;}
+constexpr double TrigMax(double d1, double d2) {return (d1 > d2)? d1 : d2;}
+constexpr long TrigRound(double d) {return (long)(d + 0.5);}    // d >= 0
+
+// sin(x) for 0..PI/2, Taylor series: term n+1 = term n * -x^2 / ((2n+2)(2n+3))
+constexpr double TrigSinSeries(double x2, double dTerm, int n)
+{
+    return (n > 12 || TrigAbs(dTerm) < 1e-12)? 0 : dTerm + TrigSinSeries(x2, -dTerm * x2 / ((2*n + 2) * (2*n + 3)), n + 1);
+}
+constexpr double TrigSin(double x) {return TrigSinSeries(x * x, x, 0);}
+
+// sqrt by Newton's method, for 0..1: the guess only goes down, stop when it does not
+constexpr double TrigSqrtIter(double d, double dGuess, double dNext)
+{
+    return (dNext < dGuess)? TrigSqrtIter(d, dNext, (dNext + d / dNext) / 2) : dGuess;
+}
+constexpr double TrigSqrt(double d) {return d? TrigSqrtIter(d, 2.0, 1.0 + d / 2) : 0;}
+
+// asin(z) for 0..0.71: term n+1 = term n * z^2 * (2n+1)^2 / ((2n+2)(2n+3))
+constexpr double TrigASinSeries(double z2, double dTerm, int n)
+{
+    return (n > 40 || dTerm < 1e-12)? 0 : dTerm + TrigASinSeries(z2, dTerm * z2 * (2*n + 1) * (2*n + 1) / ((2*n + 2) * (2*n + 3)), n + 1);
+}
+constexpr double TrigASin(double z) {return TrigASinSeries(z * z, z, 0);}
+// acos(x) for 0..1, as PI/2 - asin(x) or 2*asin(sqrt((1-x)/2)), so z stays <= 0.5
+// and the series short
+constexpr double TrigACos(double x)
+{
+    return (x < 0.5)? TRIG_PI / 2 - TrigASin(x) : 2 * TrigASin(TrigSqrt((1 - x) / 2));
+}
+
+// Largest F(i) for i = iLo..iHi-1, split in halves so the recursion stays shallow
+template <class F> constexpr double TrigMaxOver(int iLo, int iHi)
+{
+    return (iHi - iLo == 1)? F::Err4(iLo)
+            : TrigMax(TrigMaxOver<F>(iLo, iLo + (iHi - iLo) / 2), TrigMaxOver<F>(iLo + (iHi - iLo) / 2, iHi));
+}
+
+// 0, 1 .. N-1 as a template parameter pack, the tables are built from it
+template <int... I> struct TRIGSEQ {};
+template <class S1, class S2> struct TRIGCAT;
+template <int... I1, int... I2> struct TRIGCAT<TRIGSEQ<I1...>, TRIGSEQ<I2...> > {
+    typedef TRIGSEQ<I1..., ((int)sizeof...(I1) + I2)...> type;
+};
+template <int N> struct TRIGMAKESEQ {
+    typedef typename TRIGCAT<typename TRIGMAKESEQ<N / 2>::type, typename TRIGMAKESEQ<N - N / 2>::type>::type type;
+};
+template <> struct TRIGMAKESEQ<0> {typedef TRIGSEQ<> type;};
+template <> struct TRIGMAKESEQ<1> {typedef TRIGSEQ<0> type;};
+
+template <bool f, class T1, class T2> struct TRIGIF {typedef T1 type;};
+template <class T1, class T2> struct TRIGIF<false, T1, T2> {typedef T2 type;};
+
+//-----------------------------------------------------------------------------
+// The table of T in flash, entry i is T::Gen(i)
+//-----------------------------------------------------------------------------
+template <class T, class S = typename TRIGMAKESEQ<T::cEntries>::type> struct TRIGTABLE;
+template <class T, int... I> struct TRIGTABLE<T, TRIGSEQ<I...> > {
+    static const typename T::ENTRY a[sizeof...(I)] PROGMEM;
+};
+template <class T, int... I> const typename T::ENTRY TRIGTABLE<T, TRIGSEQ<I...> >::a[sizeof...(I)] PROGMEM = {
+    (typename T::ENTRY)T::Gen(I)...
+};
+
+inline long TrigRead(const byte *pb) {return pgm_read_byte(pb);}
+inline long TrigRead(const word *pw) {return pgm_read_word(pw);}
+
+template <class T> struct TRIGGEN {
+    static constexpr long Get(int i) {return T::Gen(i);}
+};
+template <class T> struct TRIGPGM {
+    static long Get(int i) {return TrigRead(&TRIGTABLE<T>::a[i]);}
+};
+
+//-----------------------------------------------------------------------------
+// Sin table: sin(i*STEP1 0.1 deg) times ONE for 0..90 deg
+//-----------------------------------------------------------------------------
+template <int STEP1, long ONE, bool fINTERP> struct TRIGSIN {
+    typedef word ENTRY;
+    static constexpr int cEntries = 900 / STEP1 + 1;
+    static constexpr long Gen(int i) {return TrigRound(TrigSin(i * STEP1 * TRIG_PI / 1800) * ONE);}
+
+    // Sin of Angle1 (0..900, decimals = 1) times ONE, from the entries E gets
+    template <class E> static constexpr long Lookup(int Angle1)
+    {
+        return (!fINTERP || !(Angle1 % STEP1))? E::Get(Angle1 / STEP1)
+                : E::Get(Angle1 / STEP1) + ((E::Get(Angle1 / STEP1 + 1) - E::Get(Angle1 / STEP1)) * (Angle1 % STEP1)
+                        + STEP1 / 2) / STEP1;
+    }
+
+    // Error of the lookup of Angle1, in 1e-4
+    static constexpr double Err4(int Angle1)
+    {
+        return TrigAbs(Lookup<TRIGGEN<TRIGSIN> >(Angle1) - TrigSin(Angle1 * TRIG_PI / 1800) * ONE) * 10000 / ONE;
+    }
+    static constexpr double MaxErr4(void) {return TrigMaxOver<TRIGSIN>(0, 901);}
+};
+
+//-----------------------------------------------------------------------------
+// ArcCos table in three parts, finer near cos = 1 where acos is steep: cos 0 to
+// 0.9 by S0, 0.9 to 0.99 by S1 and 0.99 to 1 by S2 (cos decimals = 4).  With 8
+// BITS the entries are the angle in 1/255 of PI/2, with 16 in radians,
+// decimals = 4.  To interpolate each part gets the entry after its end too.
+//-----------------------------------------------------------------------------
+template <int S0, int S1, int S2, int BITS, bool fINTERP> struct TRIGACOS {
+    typedef typename TRIGIF<(BITS > 8), word, byte>::type ENTRY;
+    static constexpr int N0 = (9000 + S0 - 1) / S0 + fINTERP;
+    static constexpr int N1 = (900 + S1 - 1) / S1 + fINTERP;
+    static constexpr int cEntries = N0 + N1 + 100 / S2 + 1;
+
+    static constexpr long Cos4(int i)
+    {
+        return (i < N0)? (long)i * S0 : (i < N0 + N1)? 9000 + (long)(i - N0) * S1 : 9900 + (long)(i - N0 - N1) * S2;
+    }
+    static constexpr long Gen(int i)
+    {
+        return (BITS > 8)? TrigRound(TrigACos((Cos4(i) > 10000)? 1.0 : Cos4(i) / 10000.0) * 10000)
+                : TrigRound(TrigACos((Cos4(i) > 10000)? 1.0 : Cos4(i) / 10000.0) * 255 / (TRIG_PI / 2));
+    }
+
+    static constexpr int Index(int cos4)
+    {
+        return (cos4 < 9000)? cos4 / S0 : (cos4 < 9900)? N0 + (cos4 - 9000) / S1 : N0 + N1 + (cos4 - 9900) / S2;
+    }
+    static constexpr int Step(int cos4) {return (cos4 < 9000)? S0 : (cos4 < 9900)? S1 : S2;}
+    static constexpr int Frac(int cos4)
+    {
+        return ((cos4 < 9000)? cos4 : (cos4 < 9900)? cos4 - 9000 : cos4 - 9900) % Step(cos4);
+    }
+    // Entry times the step, interpolated
+    template <class E> static constexpr long Raw(int cos4)
+    {
+        return (!fINTERP || !Frac(cos4))? E::Get(Index(cos4)) * Step(cos4)
+                : E::Get(Index(cos4)) * Step(cos4) + (E::Get(Index(cos4) + 1) - E::Get(Index(cos4))) * Frac(cos4);
+    }
+
+    // ArcCos of cos4 (0..10000) in radians, decimals = 4; 616 = acos resolution (pi/2/255)
+    template <class E> static constexpr long Lookup(int cos4)
+    {
+        return (BITS > 8)? Raw<E>(cos4) / Step(cos4) : (Raw<E>(cos4) * 616) / (10L * Step(cos4));
+    }
+
+    static constexpr double Err4(int cos4)
+    {
+        return TrigAbs(Lookup<TRIGGEN<TRIGACOS> >(cos4) - TrigACos(cos4 / 10000.0) * 10000);
+    }
+    static constexpr double MaxErr4(void) {return TrigMaxOver<TRIGACOS>(0, 10001);}
+};
+
+//-----------------------------------------------------------------------------
+// The tables for Hex_Cfg.h
+//-----------------------------------------------------------------------------
+#ifdef OPT_TRIGINTERP
+#define TRIG_INTERP     true
+#else
+#define TRIG_INTERP     false
+#endif
+typedef TRIGSIN<cTRIG_SINSTEP1, cSINCOS_ONE, TRIG_INTERP> TRIGSINCFG;
+typedef TRIGACOS<cTRIG_ACOSSTEP0, cTRIG_ACOSSTEP1, cTRIG_ACOSSTEP2, cTRIG_ACOSBITS, TRIG_INTERP> TRIGACOSCFG;
+
+static_assert((cTRIG_SINSTEP1 > 0) && (900 % cTRIG_SINSTEP1 == 0), "cTRIG_SINSTEP1 has to divide 900");
+static_assert((cTRIG_ACOSSTEP2 > 0) && (100 % cTRIG_ACOSSTEP2 == 0), "cTRIG_ACOSSTEP2 has to divide 100");
+static_assert((cTRIG_ACOSBITS == 8) || (cTRIG_ACOSBITS == 16), "cTRIG_ACOSBITS is 8 or 16");
+static_assert(TRIGSINCFG::MaxErr4() <= cTRIG_SINMAXERR4, "sin table steps too big for cTRIG_SINMAXERR4");
+#ifndef OPT_CORDIC_ATAN2
+static_assert(TRIGACOSCFG::MaxErr4() <= cTRIG_ACOSMAXERR4, "arccos table steps too big for cTRIG_ACOSMAXERR4");
+#endif
+
+#endif //_HEX_TRIG_H_
@@ -36,6 +36,12 @@
 #include <pins_arduino.h>
 #include <SoftwareSerial.h>        
 #include "Hex_globals.h"
+#ifdef OPT_FIXEDPOINT
+#include "Hex_Fixed.h"
+#endif
+#ifdef OPT_LEGTEMPLATES
+#include "Hex_Robot.h"
+#endif
 #define BalanceDivFactor 6    //;Other values than 6 can be used, testing...CAUTION!! At your own risk ;)
 
 #ifndef ARDPRINTF
@@ -95,6 +101,18 @@ int ardprintf(char *str, ...)
 
 //--------------------------------------------------------------------
 //[TABLES]
+#ifdef OPT_CORDIC_ATAN2
+//CORDIC angles ArcTan(2^-i) in radians, decimals = 4, times 64 so the
+//rounding of the table does not add up over the iterations
+#define cCordicPI       2010619     //PI in the same unit
+#define cCordicInvK16   39797       //1/CORDIC gain, 16 bit fraction
+static const long GetCordicAtan[] PROGMEM = {
+                    502655, 296734, 156786, 79587, 39948, 19993, 9999, 5000, 2500, 1250, 625, 312, 156, 78, 39, 20 };
+
+#if (cCORDIC_ITERATIONS < 8) || (cCORDIC_ITERATIONS > 16)
+#error cCORDIC_ITERATIONS must be 8..16
+#endif
+#elif !defined(OPT_TRIGTABLES)
 //ArcCosinus Table
 //Table build in to 3 part to get higher accuracy near cos = 1. 
 //The biggest error is near cos = 1 and has a biggest value of 3*0.012098rad = 0.521 deg.
@@ -114,7 +132,23 @@ static const byte GetACos[] PROGMEM = {
                     46,46,45,45,44,44,43,43,42,42,41,41,40,40,39,39,38,37,37,36,36,35,34,34,33,33,32,31,31,30,29,28,
                     28,27,26,25,24,23,23,23,23,22,22,22,22,21,21,21,21,20,20,20,19,19,19,19,18,18,18,17,17,17,17,16,
                     16,16,15,15,15,14,14,13,13,13,12,12,11,11,10,10,9,9,8,7,6,6,5,3,0 };//
+#endif
                     
+#ifdef OPT_TRIGTABLES
+#include "Hex_Trig.h"      // the compiler builds the ArcCos and Sin tables
+#elif defined(OPT_FIXEDPOINT)
+//Sin table 90 deg, persision 0.5 deg [181 values], 14 fraction bits (16384 = 1)
+static const word GetSin[] PROGMEM = {0, 143, 286, 429, 572, 715, 857, 1000, 1143, 1285, 1428, 1570, 1713, 1855, 1997, 2139, 2280, 2422, 2563, 
+                 2704, 2845, 2986, 3126, 3266, 3406, 3546, 3686, 3825, 3964, 4102, 4240, 4378, 4516, 4653, 4790, 4927, 5063, 
+                 5199, 5334, 5469, 5604, 5738, 5872, 6005, 6138, 6270, 6402, 6533, 6664, 6794, 6924, 7053, 7182, 7311, 7438, 
+                 7565, 7692, 7818, 7943, 8068, 8192, 8316, 8438, 8561, 8682, 8803, 8923, 9043, 9162, 9280, 9397, 9514, 9630, 
+                 9746, 9860, 9974, 10087, 10199, 10311, 10422, 10531, 10641, 10749, 10856, 10963, 11069, 11174, 11278, 11381, 11484, 11585, 
+                 11686, 11786, 11885, 11982, 12080, 12176, 12271, 12365, 12458, 12551, 12642, 12733, 12822, 12911, 12998, 13085, 13170, 13255, 
+                 13338, 13421, 13502, 13583, 13662, 13741, 13818, 13894, 13970, 14044, 14117, 14189, 14260, 14330, 14399, 14466, 14533, 14598, 
+                 14663, 14726, 14788, 14849, 14909, 14968, 15025, 15082, 15137, 15191, 15244, 15296, 15346, 15396, 15444, 15491, 15537, 15582, 
+                 15626, 15668, 15709, 15749, 15788, 15826, 15862, 15897, 15931, 15964, 15996, 16026, 16055, 16083, 16110, 16135, 16159, 16182, 
+                 16204, 16225, 16244, 16262, 16279, 16294, 16309, 16322, 16333, 16344, 16353, 16362, 16368, 16374, 16378, 16382, 16383, 16384 };
+#else
 //Sin table 90 deg, persision 0.5 deg [180 values]
 static const word GetSin[] PROGMEM = {0, 87, 174, 261, 348, 436, 523, 610, 697, 784, 871, 958, 1045, 1132, 1218, 1305, 1391, 1478, 1564, 
                  1650, 1736, 1822, 1908, 1993, 2079, 2164, 2249, 2334, 2419, 2503, 2588, 2672, 2756, 2840, 2923, 3007, 
@@ -127,6 +161,7 @@ static const word GetSin[] PROGMEM = {0, 87, 174, 261, 348, 436, 523, 610, 697,
                  9335, 9366, 9396, 9426, 9455, 9483, 9510, 9537, 9563, 9588, 9612, 9636, 9659, 9681, 9702, 9723, 9743, 
                  9762, 9781, 9799, 9816, 9832, 9848, 9862, 9876, 9890, 9902, 9914, 9925, 9935, 9945, 9953, 9961, 9969, 
                  9975, 9981, 9986, 9990, 9993, 9996, 9998, 9999, 10000 };//
+#endif
 
 
 //Build tables for Leg configuration like I/O and MIN/imax values to easy access values using a FOR loop
@@ -178,6 +213,20 @@ const byte cTibiaLength[] PROGMEM = {cRRTibiaLength, cRMTibiaLength, cRFTibiaLen
 const byte cTarsLength[] PROGMEM = {cRRTarsLength, cRMTarsLength, cRFTarsLength, cLRTarsLength, cLMTarsLength, cLFTarsLength};
 #endif
 
+//Femur and tibia angles over the leg workspace
+#ifdef OPT_IKTABLE
+#include "Hex_IKTable.h"
+#ifdef c4DOF
+#error OPT_IKTABLE only supports 3DOF legs
+#endif
+#if (cRRFemurLength != cIKTAB_FEMUR) || (cRMFemurLength != cIKTAB_FEMUR) || (cRFFemurLength != cIKTAB_FEMUR) \
+        || (cLRFemurLength != cIKTAB_FEMUR) || (cLMFemurLength != cIKTAB_FEMUR) || (cLFFemurLength != cIKTAB_FEMUR) \
+        || (cRRTibiaLength != cIKTAB_TIBIA) || (cRMTibiaLength != cIKTAB_TIBIA) || (cRFTibiaLength != cIKTAB_TIBIA) \
+        || (cLRTibiaLength != cIKTAB_TIBIA) || (cLMTibiaLength != cIKTAB_TIBIA) || (cLFTibiaLength != cIKTAB_TIBIA)
+#error Hex_IKTable.h is for other leg lengths, run "make -C host iktable"
+#endif
+#endif
+
 
 //Body Offsets [distance between the center of the body and the center of the coxa]
 const short cOffsetX[] PROGMEM = {cRROffsetX, cRMOffsetX, cRFOffsetX, cLROffsetX, cLMOffsetX, cLFOffsetX};
@@ -191,6 +240,38 @@ const short cInitPosX[] PROGMEM = {cRRInitPosX, cRMInitPosX, cRFInitPosX, cLRIni
 const short cInitPosY[] PROGMEM = {cRRInitPosY, cRMInitPosY, cRFInitPosY, cLRInitPosY, cLMInitPosY, cLFInitPosY};
 const short cInitPosZ[] PROGMEM = {cRRInitPosZ, cRMInitPosZ, cRFInitPosZ, cLRInitPosZ, cLMInitPosZ, cLFInitPosZ};
 
+//Gaits
+//The action of a leg P steps after its lift step, in a gait of S steps with N lifted positions.
+//The order is the priority when more than one would match.
+#define GAITWALK(P,N,S) ((((P)==0) && ((N)&1))? cGaitUp :                                  \
+                        ((((N)==2) && ((P)==0)) || (((N)>=3) && ((P)==(S)-1)))? cGaitHalfRear : \
+                        (((N)>=2) && ((P)==1))? cGaitHalfFront :                           \
+                        (((N)==5) && ((P)==(S)-2))? cGaitRear2 :                           \
+                        (((N)==5) && ((P)==2))? cGaitFront2 :                              \
+                        ((P)==(N))? cGaitDown : cGaitPush)
+#define GAITSTAND(P,N,S) (((P)==0)? cGaitUpHome : ((P)==(N))? cGaitDown : cGaitPush)
+#define GAITPHASE(P,N,S) (((P) < (S))? ((GAITSTAND(P,N,S) << 4) | GAITWALK(P,N,S)) : 0)
+#define GAITPHASES(N,S) {GAITPHASE(0,N,S), GAITPHASE(1,N,S), GAITPHASE(2,N,S), GAITPHASE(3,N,S),       \
+                         GAITPHASE(4,N,S), GAITPHASE(5,N,S), GAITPHASE(6,N,S), GAITPHASE(7,N,S),       \
+                         GAITPHASE(8,N,S), GAITPHASE(9,N,S), GAITPHASE(10,N,S), GAITPHASE(11,N,S),     \
+                         GAITPHASE(12,N,S), GAITPHASE(13,N,S), GAITPHASE(14,N,S), GAITPHASE(15,N,S),   \
+                         GAITPHASE(16,N,S), GAITPHASE(17,N,S), GAITPHASE(18,N,S), GAITPHASE(19,N,S),   \
+                         GAITPHASE(20,N,S), GAITPHASE(21,N,S), GAITPHASE(22,N,S), GAITPHASE(23,N,S)}
+#define GAIT(RR, RM, RF, LR, LM, LF, LIFTED, HALF, TLDIV, STEPS, SPEED) \
+        {{RR, RM, RF, LR, LM, LF}, LIFTED, HALF, TLDIV, STEPS, SPEED, GAITPHASES(LIFTED, STEPS)}
+
+//Add a gait by adding a line (and updating NUM_GAITS), the select button steps through them
+static const GAITDEF GaitDefs[] PROGMEM = {
+    //   Lift step of the legs      Lifted  Half  TLDiv  Steps  Speed
+    //   RR  RM  RF  LR  LM  LF
+    GAIT( 7, 11,  3,  1,  5,  9,       3,    3,     8,    12,    70),   //Ripple 12 steps
+    GAIT( 1,  5,  1,  5,  1,  5,       3,    3,     4,     8,    70),   //Tripod 8 steps
+    GAIT( 5, 10,  3, 11,  4,  9,       3,    3,     8,    12,    60),   //Triple Tripod 12 steps
+    GAIT( 6, 13,  4, 14,  5, 12,       5,    1,    10,    16,    60),   //Triple Tripod 16 steps, 5 lifted positions
+    GAIT(13, 17, 21,  1,  5,  9,       3,    3,    20,    24,    70)    //Wave 24 steps
+};
+typedef char GaitDefsMatchNUM_GAITS[(sizeof(GaitDefs)/sizeof(GaitDefs[0]) == NUM_GAITS)? 1 : -1];
+
 
 // Define some globals for debug information
 boolean g_fShowDebugPrompt;
@@ -231,27 +312,11 @@ boolean         Eyes;    //Eyes output
 byte            Index;                    //Index universal used
 byte            LegIndex;                //Index used for leg Index Number
 
-//GetSinCos / ArcCos
-short           AngleDeg1;        //Input Angle in degrees, decimals = 1
-short           sin4;             //Output Sinus of the given Angle, decimals = 4
-short           cos4;            //Output Cosinus of the given Angle, decimals = 4
-short           AngleRad4;        //Output Angle in radials, decimals = 4
-
-//GetAtan2
-short           AtanX;            //Input X
-short           AtanY;            //Input Y
-short           Atan4;            //ArcTan2 output
-short           XYhyp2;            //Output presenting Hypotenuse of X and Y
-
 //Body Inverse Kinematics
-short           PosX;            //Input position of the feet X
-short           PosZ;            //Input position of the feet Z
-short           PosY;            //Input position of the feet Y
-//long          TotalX;            //Total X distance between the center of the body and the feet
-//long          TotalZ;            //Total Z distance between the center of the body and the feet
-long            BodyFKPosX;        //Output Position X of feet with Rotation
-long            BodyFKPosY;        //Output Position Y of feet with Rotation
-long            BodyFKPosZ;        //Output Position Z of feet with Rotation
+BODYROT         BodyRot = {0, 0, 0, {0, cSINCOS_ONE}, {0, cSINCOS_ONE}, true, 0, {0, cSINCOS_ONE}};    //Sin/Cos of the body rotation, GetSinCos(0) to start
+#if defined(OPT_FIXEDPOINT) && defined(QNUM_CHECK)
+unsigned long   g_cQNumOverflows;   // fixed point results that did not fit, see Hex_Fixed.h
+#endif
 // New with zentas stuff
 short           BodyRotOffsetX;    //Input X offset value to adjust centerpoint of rotation
 short           BodyRotOffsetY;    //Input Y offset value to adjust centerpoint of rotation
@@ -259,17 +324,17 @@ short           BodyRotOffsetZ;    //Input Z offset value to adjust centerpoint
 
 
 //Leg Inverse Kinematics
-long            IKFeetPosX;        //Input position of the Feet X
-long            IKFeetPosY;        //Input position of the Feet Y
-long            IKFeetPosZ;        //Input Position of the Feet Z
-boolean         IKSolution;        //Output true if the solution is possible
-boolean         IKSolutionWarning;    //Output true if the solution is NEARLY possible
-boolean         IKSolutionError;    //Output true if the solution is NOT possible
+LEGIKCONST      LegIKConst[6];    //Leg lengths and their products, see InitLegIKConst
+
+//Leg Inverse Kinematics - combined status of the legs this cycle
+boolean         IKSolution;        //True if the solution is possible
+boolean         IKSolutionWarning;    //True if the solution is NEARLY possible
+boolean         IKSolutionError;    //True if the solution is NOT possible
 //--------------------------------------------------------------------
 //[TIMING]
 unsigned long   lTimerStart;    //Start time of the calculation cycles
 unsigned long   lTimerEnd;        //End time of the calculation cycles
-byte            CycleTime;        //Total Cycle time
+word            CycleTime;        //Total Cycle time
 
 word            ServoMoveTime;        //Time for servo updates
 word            PrevServoMoveTime;    //Previous time for the servo updates
@@ -298,6 +363,17 @@ long            TotalTransY;
 long            TotalYBal1;
 long            TotalXBal1;
 long            TotalZBal1;
+#ifdef OPT_BALANCE_CACHE
+BALLEG          g_aBalLegs[6];      // each leg's part, see BalCalcOneLeg
+BALBODY         g_BalBody;          // last result of BalanceBody
+boolean         g_fBalChanged;      // a leg's part changed since the last BalanceBody
+#endif
+#ifdef OPT_IK_CACHE
+IKCACHELEG      g_aIKCacheLegs[6];  // see FIKCacheHit
+IKCACHEBODY     g_IKCacheBody;
+unsigned long   g_cIKCacheLegs;
+unsigned long   g_cIKCacheHits;
+#endif
 
 //[Single Leg Control]
 byte            PrevSelectedLeg;
@@ -310,7 +386,7 @@ short           TLDivFactor;         //Number of steps that a leg is on the floo
 short           NrLiftedPos;         //Number of positions that a single leg is lifted [1-3]
 byte            LiftDivFactor;       //Normaly: 2, when NrLiftedPos=5: 4
 
-boolean         HalfLiftHeigth;      //If TRUE the outer positions of the ligted legs will be half height    
+byte            HalfLiftHeigth;      //Outer positions of the lifted legs: 0 full, 3 half and 1 3/4 height
 
 boolean         TravelRequest;        //Temp to check if the gait is in motion
 byte            StepsInGait;         //Number of steps in gait
@@ -319,6 +395,7 @@ boolean         LastLeg;             //TRUE when the current leg is the last leg
 byte            GaitStep;            //Actual Gait step
 
 byte            GaitLegNr[6];        //Init position of the leg
+const byte      *pGaitPhases;        //Action by phase of the gait (PROGMEM), see GaitDefs
 
 byte            GaitLegNrIn;         //Input Number of the leg
 
@@ -327,6 +404,19 @@ long            GaitPosY[6];         //Array containing Relative Y position corr
 long            GaitPosZ[6];         //Array containing Relative Z position corresponding to the Gait
 long            GaitRotY[6];         //Array containing Relative Y rotation corresponding to the Gait
 
+#if defined(OPT_STREAMING) && !defined(OPT_SCHEDULER)
+#error OPT_STREAMING needs OPT_SCHEDULER
+#endif
+#ifdef OPT_GAITPHASE
+word            wGaitPhase;          //Fraction of the way from GaitStep to the next step, 1/65536
+word            wGaitPhaseRem;       //and the remainder of that, 1/(65536*step time)
+unsigned long   lGaitPhaseTime;      //lTimerStart of the last GaitSeq
+short           GaitStepPosX[6];     //GaitPos at the last whole step, GaitPos is interpolated from it
+short           GaitStepPosY[6];
+short           GaitStepPosZ[6];
+short           GaitStepRotY[6];
+#endif
+
 
 boolean         fWalking;            //  True if the robot are walking
 boolean         fContinueWalking;    // should we continue to walk?
@@ -346,10 +436,54 @@ extern void CheckAngles();
 
 extern void    PrintSystemStuff(void);            // Try to see why we fault...
 extern void BalCalcOneLeg (short PosX, short PosZ, short PosY, byte BalLegNr);
-extern void BodyFK (short PosX, short PosZ, short PosY, short RotationY, byte BodyIKLeg) ;
-extern void LegIK (short IKFeetPosX, short IKFeetPosY, short IKFeetPosZ, byte LegIKLegNr);
+extern short BalATan2Deg1 (short AtanX, short AtanY);
+extern void BodyRotUpdate (BODYROT *pBodyRot, short RotX1, long RotY1, short RotZ1);
+extern COORD3D BodyFK (BODYROT *pBodyRot, short PosX, short PosZ, short PosY, short RotationY, byte BodyIKLeg) ;
+extern COORD3D BodyFKCPR (BODYROT *pBodyRot, short CPR_X, short CPR_Z, short CPR_Y, short RotationY);
+extern void InitLegIKConst (void);
+#ifdef OPT_IKTABLE
+extern boolean LegIKTable (LEGIKSOLUTION *pIKSol, short IKFeetPosXZ, short IKFeetPosY, LEGIKCONST *pLeg);
+#endif
+extern LEGIKSOLUTION LegIK (short IKFeetPosX, short IKFeetPosY, short IKFeetPosZ, byte LegIKLegNr);
+extern void SetLegIK (byte LegIKLegNr, LEGIKSOLUTION IKSol);
+extern void AddIKStatus (byte bStatus);
+#ifdef OPT_IK_CACHE
+extern void IKCacheBody (void);
+extern boolean FIKCacheHit (byte LegIKLegNr, short PosX, short PosZ, short PosY, short RotationY);
+#endif
 extern void Gait (byte GaitCurrentLegNr);
-extern short GetATan2 (short AtanX, short AtanY);
+extern SINCOS GetSinCos (short AngleDeg1);
+extern long GetArcCos (short cos4);
+extern ATAN2 GetATan2 (short AtanX, short AtanY);
+extern unsigned long isqrt32 (unsigned long n);
+#ifdef OPT_FIXEDPOINT
+extern short Rad4ToDeg1 (long Rad4);
+#endif
+#ifdef OPT_SCHEDULER
+extern void PrintSchedStats (void);
+#endif
+#ifdef OPT_IDLE
+extern boolean FIdleCycle (void);
+#endif
+#ifdef OPT_PROFILE
+extern void PrintProfile (void);
+#endif
+#ifdef OPT_SSC_MOVESYNC
+extern void MoveSyncWait (word wMaxMS);
+#endif
+#ifdef OPT_LEGTEMPLATES
+extern void LegsIK (void);
+
+//The steps of loop() that go leg by leg, one copy per leg with its LEGDESC constants
+template <byte LEG> struct LEGPIPE {
+    static void Balance(void);      //BalCalcOneLeg of the leg
+    static void FKIK(void);         //BodyFK and LegIK of the leg
+    static void Limit(void);        //CheckAngles of the leg
+    static void Output(void);       //its servos to the servo driver
+};
+#define LEGS_DO(F)  do { LEGPIPE<cRR>::F(); LEGPIPE<cRM>::F(); LEGPIPE<cRF>::F(); \
+                         LEGPIPE<cLR>::F(); LEGPIPE<cLM>::F(); LEGPIPE<cLF>::F(); } while (0)
+#endif
 
 
 //--------------------------------------------------------------------------
@@ -395,6 +529,7 @@ void setup(){
         LegPosY[LegIndex] = (short)pgm_read_word(&cInitPosY[LegIndex]);
         LegPosZ[LegIndex] = (short)pgm_read_word(&cInitPosZ[LegIndex]);  
     }
+    InitLegIKConst();
     
     //Single leg control. Make sure no leg is selected
     g_InControlState.SelectedLeg = 255; // No Leg selected
@@ -427,6 +562,9 @@ void setup(){
     ServoMoveTime = 150;
     g_InControlState.fHexOn = 0;
     g_fLowVoltageShutdown = false;
+#ifdef OPT_SCHEDULER
+    SchedStart();
+#endif
 }
 
     
@@ -435,29 +573,70 @@ void setup(){
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
 void loop(void)
 {
+#ifdef OPT_SCHEDULER
+    word    wSchedPeriod = cSCHED_PERIOD;   //ms from the start of the last cycle to this one
+    boolean fSchedMoveSync = false;         //may start early, when the SSC-32 is done with the move
+#else
+    unsigned long lCycleTime;
+#endif
+#ifdef OPT_ADAPTIVE_MOVETIME
+    word    wMinMoveTime;                   //ms the servos need for the largest move of the frame
+#endif
     //[DEBUG] Simulates that the start button was pushed
     //g_InControlState.fHexOn = 1;
     //Start time
     lTimerStart = millis(); 
+    g_ServoDriver.TxService();      // keep the previous frame going out while we compute the next one
+#ifdef OPT_SOUNDQUEUE
+    SoundService();
+#endif
     //Read input
+    PROF_BEGIN();
     CheckVoltage();        // check our voltages...
-    if (!g_fLowVoltageShutdown)
+    PROF_END(cPROF_VOLTAGE);
+    if (!g_fLowVoltageShutdown) {
+        PROF_BEGIN();
         g_InputController.ControlInput();
+        PROF_END(cPROF_INPUT);
+    }
     
     WriteOutputs();        // Write Outputs
    
 #ifdef OPT_GPPLAYER
     //GP Player
+    PROF_BEGIN();
     g_ServoDriver.GPPlayer();
+    PROF_END(cPROF_GPPLAYER);
+#endif
+
+#ifdef OPT_IDLE
+    //Nothing changed for a while: no gait, IK or frame, read the input again later
+    if (FIdleCycle()) {
+#ifdef OPT_TERMINAL_MONITOR
+        if (!g_InControlState.fHexOn && TerminalMonitor())
+            return;
+#endif
+#ifdef OPT_SCHEDULER
+        SchedWait(cIDLE_PERIOD, false);
+#else
+        g_ServoDriver.TxDelay(cIDLE_PERIOD);
+#endif
+        return;
+    }
 #endif
 
     //Single leg control
+    PROF_BEGIN();
     SingleLegControl ();
+    PROF_END(cPROF_SINGLELEG);
             
     //Gait
+    PROF_BEGIN();
     GaitSeq();
+    PROF_END(cPROF_GAIT);
              
     //Balance calculations
+    PROF_BEGIN();
     TotalTransX = 0;    
     TotalTransZ = 0;
     TotalTransY = 0;
@@ -465,6 +644,9 @@ void loop(void)
     TotalYBal1  = 0;
     TotalZBal1  = 0;
     if (g_InControlState.BalanceMode) {
+#ifdef OPT_LEGTEMPLATES
+        LEGS_DO(Balance);
+#else
         for (LegIndex = 0; LegIndex <= 2; LegIndex++) {    // balance calculations for all Right legs
             BalCalcOneLeg (-LegPosX[LegIndex]+GaitPosX[LegIndex], 
                         LegPosZ[LegIndex]+GaitPosZ[LegIndex], 
@@ -476,38 +658,69 @@ void loop(void)
                         LegPosZ[LegIndex]+GaitPosZ[LegIndex], 
                         (LegPosY[LegIndex]-(short)pgm_read_word(&cInitPosY[LegIndex]))+GaitPosY[LegIndex], LegIndex);
         }
+#endif
         BalanceBody();
     }          
+    PROF_END(cPROF_BALANCE);
      //Reset Inverse Kinematic Solution Indicators  
      IKSolution = 0 ;
      IKSolutionWarning = 0; 
      IKSolutionError = 0 ;
+
+     //Body rotation is the same for all legs, only look it up when it changed
+     PROF_BEGIN();
+     BodyRotUpdate(&BodyRot, g_InControlState.BodyRot1.x+TotalXBal1, g_InControlState.BodyRot1.y+TotalYBal1,
+             g_InControlState.BodyRot1.z+TotalZBal1);
+#ifdef OPT_IK_CACHE
+     IKCacheBody();
+#endif
             
+#ifdef OPT_LEGTEMPLATES
+     LegsIK();
+#else
      //Do IK for all Right legs
      for (LegIndex = 0; LegIndex <=2; LegIndex++) {    
-        BodyFK(-LegPosX[LegIndex]+g_InControlState.BodyPos.x+GaitPosX[LegIndex] - TotalTransX,
+#ifdef OPT_IK_CACHE
+        if (FIKCacheHit(LegIndex, -LegPosX[LegIndex]+g_InControlState.BodyPos.x+GaitPosX[LegIndex] - TotalTransX,
+                LegPosZ[LegIndex]+g_InControlState.BodyPos.z+GaitPosZ[LegIndex] - TotalTransZ,
+                LegPosY[LegIndex]+g_InControlState.BodyPos.y+GaitPosY[LegIndex] - TotalTransY, GaitRotY[LegIndex]))
+            continue;
+#endif
+        COORD3D BodyFKPos = BodyFK(&BodyRot, -LegPosX[LegIndex]+g_InControlState.BodyPos.x+GaitPosX[LegIndex] - TotalTransX,
                 LegPosZ[LegIndex]+g_InControlState.BodyPos.z+GaitPosZ[LegIndex] - TotalTransZ,
                 LegPosY[LegIndex]+g_InControlState.BodyPos.y+GaitPosY[LegIndex] - TotalTransY,
                 GaitRotY[LegIndex], LegIndex);
                                
-        LegIK (LegPosX[LegIndex]-g_InControlState.BodyPos.x+BodyFKPosX-(GaitPosX[LegIndex] - TotalTransX), 
-                LegPosY[LegIndex]+g_InControlState.BodyPos.y-BodyFKPosY+GaitPosY[LegIndex] - TotalTransY,
-                LegPosZ[LegIndex]+g_InControlState.BodyPos.z-BodyFKPosZ+GaitPosZ[LegIndex] - TotalTransZ, LegIndex);
+        SetLegIK(LegIndex, LegIK (LegPosX[LegIndex]-g_InControlState.BodyPos.x+BodyFKPos.x-(GaitPosX[LegIndex] - TotalTransX), 
+                LegPosY[LegIndex]+g_InControlState.BodyPos.y-BodyFKPos.y+GaitPosY[LegIndex] - TotalTransY,
+                LegPosZ[LegIndex]+g_InControlState.BodyPos.z-BodyFKPos.z+GaitPosZ[LegIndex] - TotalTransZ, LegIndex));
     }
           
     //Do IK for all Left legs  
     for (LegIndex = 3; LegIndex <=5; LegIndex++) {
-        BodyFK(LegPosX[LegIndex]-g_InControlState.BodyPos.x+GaitPosX[LegIndex] - TotalTransX,
+#ifdef OPT_IK_CACHE
+        if (FIKCacheHit(LegIndex, LegPosX[LegIndex]-g_InControlState.BodyPos.x+GaitPosX[LegIndex] - TotalTransX,
+                LegPosZ[LegIndex]+g_InControlState.BodyPos.z+GaitPosZ[LegIndex] - TotalTransZ,
+                LegPosY[LegIndex]+g_InControlState.BodyPos.y+GaitPosY[LegIndex] - TotalTransY, GaitRotY[LegIndex]))
+            continue;
+#endif
+        COORD3D BodyFKPos = BodyFK(&BodyRot, LegPosX[LegIndex]-g_InControlState.BodyPos.x+GaitPosX[LegIndex] - TotalTransX,
                 LegPosZ[LegIndex]+g_InControlState.BodyPos.z+GaitPosZ[LegIndex] - TotalTransZ,
                 LegPosY[LegIndex]+g_InControlState.BodyPos.y+GaitPosY[LegIndex] - TotalTransY,
                 GaitRotY[LegIndex], LegIndex);
-        LegIK (LegPosX[LegIndex]+g_InControlState.BodyPos.x-BodyFKPosX+GaitPosX[LegIndex] - TotalTransX,
-                LegPosY[LegIndex]+g_InControlState.BodyPos.y-BodyFKPosY+GaitPosY[LegIndex] - TotalTransY,
-                LegPosZ[LegIndex]+g_InControlState.BodyPos.z-BodyFKPosZ+GaitPosZ[LegIndex] - TotalTransZ, LegIndex);
+        SetLegIK(LegIndex, LegIK (LegPosX[LegIndex]+g_InControlState.BodyPos.x-BodyFKPos.x+GaitPosX[LegIndex] - TotalTransX,
+                LegPosY[LegIndex]+g_InControlState.BodyPos.y-BodyFKPos.y+GaitPosY[LegIndex] - TotalTransY,
+                LegPosZ[LegIndex]+g_InControlState.BodyPos.z-BodyFKPos.z+GaitPosZ[LegIndex] - TotalTransZ, LegIndex));
     }
+#endif
+    PROF_END(cPROF_IK);
+
+    g_ServoDriver.TxService();
 
     //Check mechanical limits
+    PROF_BEGIN();
     CheckAngles();
+    PROF_END(cPROF_ANGLES);
                 
     //Write IK errors to leds
     LedC = IKSolutionWarning;
@@ -533,14 +746,16 @@ void loop(void)
                 
             //Add aditional delay when Balance mode is on
             if (g_InControlState.BalanceMode)
-                ServoMoveTime = ServoMoveTime + 100;
+                ServoMoveTime = ServoMoveTime + cBALANCE_MOVETIME;
         } else //Movement speed excl. Walking
             ServoMoveTime = 200 + g_InControlState.SpeedControl;
         
         // note we broke up the servo driver into start/commit that way we can output all of the servo information
         // before we wait and only have the termination information to output after the wait.  That way we hopefully
         // be more accurate with our timings...
+        PROF_BEGIN();
         StartUpdateServos();
+        PROF_END(cPROF_SERVOS);
         
         // See if we need to sync our processor with the servo driver while walking to ensure the prev is completed before sending the next one
                 
@@ -556,21 +771,50 @@ void loop(void)
                 break;
             }
         }
+#ifdef OPT_STREAMING
+        //The servos get there when the next frame comes
+        if (fWalking || fContinueWalking)
+            ServoMoveTime = cSTREAM_PERIOD;
+#endif
+#ifdef OPT_ADAPTIVE_MOVETIME
+        //As fast as the servos can make the move: not slower than asked for above, and not
+        //faster than they can even when that is slower
+        wMinMoveTime = g_ServoDriver.WMinMoveTime();
+        if (wMinMoveTime != 0xffff) {
+            ServoMoveTime = min(ServoMoveTime, max(wMinMoveTime,
+                    (fWalking || fContinueWalking)? (word)NomGaitSpeed : (word)cMOVETIME_MIN));
+            ServoMoveTime = max(ServoMoveTime, wMinMoveTime);
+        }
+#endif
         if (fWalking || fContinueWalking) {
+#ifdef OPT_SCHEDULER
+#ifdef OPT_STREAMING
+            wSchedPeriod = cSTREAM_PERIOD;
+#else
+            //Next step when the previous move is done, but at least every NomGaitSpeed ms,
+            //also on the first step of a walk (like the delay without OPT_SCHEDULER)
+            wSchedPeriod = min(PrevServoMoveTime, (word)NomGaitSpeed);
+            fSchedMoveSync = true;
+#endif
+            fWalking = fContinueWalking;
+#else
             word  wDelayTime;
             fWalking = fContinueWalking;
                   
             //Get endtime and calculate wait time
             lTimerEnd = millis();
-            if (lTimerEnd > lTimerStart)
-                CycleTime = lTimerEnd-lTimerStart;
-            else
-                CycleTime = 0xffffffffL - lTimerEnd + lTimerStart + 1;
+            lCycleTime = lTimerEnd-lTimerStart;     //unsigned, so also right when millis wrapped
+            CycleTime = (lCycleTime > 0xffff)? 0xffff : lCycleTime;
             
             // if it is less, use the last cycle time...
             //Wait for previous commands to be completed while walking
             wDelayTime = (min(max ((PrevServoMoveTime - CycleTime), 1), NomGaitSpeed));
-            delay (wDelayTime); 
+#ifdef OPT_SSC_MOVESYNC
+            MoveSyncWait(wDelayTime);
+#else
+            g_ServoDriver.TxDelay(wDelayTime); 
+#endif
+#endif
         }
         
     } else { //Start button is pressed the second time, stop walking and turn the hexapod off 
@@ -585,7 +829,11 @@ void loop(void)
 #ifdef USEXBEE            
             XBeePlaySounds(3, 100, 2500, 80, 2250, 60, 2000);
 #endif            
-            delay(600);
+#ifdef OPT_SSC_MOVESYNC
+            MoveSyncWait(600);
+#else
+            g_ServoDriver.TxDelay(600);
+#endif
         } else {
             g_ServoDriver.FreeServos();
             Eyes = 0;
@@ -596,11 +844,18 @@ void loop(void)
         if (TerminalMonitor())
             return;           
 #endif
-        delay(20);  // give a pause between times we call if nothing is happening
+#ifndef OPT_SCHEDULER
+        g_ServoDriver.TxDelay(20);  // give a pause between times we call if nothing is happening
+#endif
     }
 
+#ifdef OPT_SCHEDULER
+    SchedWait(wSchedPeriod, fSchedMoveSync);
+#endif
     // Xan said Needed to be here...
+    PROF_BEGIN();
     g_ServoDriver.CommitServoDriver(ServoMoveTime);
+    PROF_END(cPROF_COMMIT);
     PrevServoMoveTime = ServoMoveTime;
 
     //Store previous g_InControlState.fHexOn State, this is required to track if the hexapod is being turned on for the first time 
@@ -610,6 +865,187 @@ void loop(void)
         g_InControlState.fPrev_HexOn = 0;
 }
 
+#ifdef OPT_SCHEDULER
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+//[SCHEDULER] Starts the cycles (commits the servo frames) at fixed times.  A deadline is
+//         the last one plus the period, not the end of the cycle plus a delay, so the
+//         cadence does not drift with the time the cycle takes.  A cycle that is done more
+//         than 1 ms after its deadline starts right away and the schedule continues from
+//         there, it does not try to catch up.  The wait goes to SchedIdle.  With fMoveSync
+//         (OPT_SSC_MOVESYNC) the cycle starts as soon as the SSC-32 is done with the move,
+//         and the schedule continues from there.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+SCHEDSTATS      g_SchedStats;
+unsigned long   ulSchedDeadline;    //micros() the last cycle was due
+
+void SchedStart(void)
+{
+    memset(&g_SchedStats, 0, sizeof(g_SchedStats));
+    ulSchedDeadline = micros();
+}
+
+//Background work while waiting for the next cycle
+void SchedIdle(void)
+{
+    g_ServoDriver.TxService();
+#ifdef OPT_SOUNDQUEUE
+    SoundService();
+#endif
+}
+
+#ifdef OPT_SSC_MOVESYNC
+void SchedWait(word wPeriod, boolean fMoveSync)
+#else
+void SchedWait(word wPeriod, boolean)
+#endif
+{
+    unsigned long   ulLate;
+    long            lWait;
+    byte            iBucket;
+    
+    ulSchedDeadline += (unsigned long)wPeriod * 1000;
+    lWait = (long)(ulSchedDeadline - micros());
+    if (lWait < 0)
+        g_SchedStats.cMissed++;
+#ifdef OPT_SSC_MOVESYNC
+    if (fMoveSync) {
+        unsigned long ulStart = micros();
+        while ((lWait > 0) && !g_ServoDriver.FMoveDone()) {
+            SchedIdle();
+            delayMicroseconds(min(lWait, 1000L));
+            lWait = (long)(ulSchedDeadline - micros());
+        }
+        PROF_ADD(cPROF_MOVEWAIT, micros() - ulStart);
+        PROF_ADD(cPROF_MOVESAVED, max(lWait, 0L));
+        if (lWait > 0) {
+            ulSchedDeadline -= lWait;   //Started early, the next period starts now
+            lWait = 0;
+        }
+    }
+#endif
+    while (lWait > 0) {
+        SchedIdle();
+        if (lWait >= 1000)
+            delay(1);
+        else
+            delayMicroseconds(lWait);
+        lWait = (long)(ulSchedDeadline - micros());
+    }
+
+    ulLate = (unsigned long)-lWait;
+    if (ulLate > g_SchedStats.ulMaxLate)
+        g_SchedStats.ulMaxLate = ulLate;
+    for (iBucket = 0; (iBucket < cSCHED_LATEBUCKETS-1) && (ulLate >= (64UL << iBucket)); iBucket++)
+        ;
+    if (g_SchedStats.awLate[iBucket] != 0xffff)
+        g_SchedStats.awLate[iBucket]++;
+    g_SchedStats.cCycles++;
+    
+    //Late: the next period starts now
+    if (ulLate >= 1000)
+        ulSchedDeadline += ulLate;
+}
+#endif
+
+#ifdef OPT_IDLE
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+//[IDLE] True when this cycle only reads the input: the input is the same as in the last
+//         cIDLE_CYCLES whole cycles, the gait is not moving the legs and no GP sequence
+//         plays.  Those cycles already sent where the legs stay, so there is nothing to
+//         work out or send.  A change ends it at once, this cycle runs whole.  Every
+//         cIDLE_KEEPALIVE ms one whole cycle runs anyway, with all servos in its frame.
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+INCONTROLSTATE  IdleInControlState;     //input of the last cycle
+byte            bIdleCycles;            //whole cycles the input stayed the same, up to cIDLE_CYCLES
+unsigned long   lIdleKeepAlive;         //millis() of the last whole cycle
+unsigned long   g_cIdleCycles;
+unsigned long   g_cIdleWakes;
+
+boolean FIdleCycle(void)
+{
+    if (memcmp(&IdleInControlState, &g_InControlState, sizeof(INCONTROLSTATE))
+            || (g_InControlState.fHexOn && (fWalking || fContinueWalking))
+#ifdef OPT_GPPLAYER
+            || g_ServoDriver.FIsGPSeqActive()
+#endif
+            ) {
+        if (bIdleCycles >= cIDLE_CYCLES)
+            g_cIdleWakes++;
+        memcpy(&IdleInControlState, &g_InControlState, sizeof(INCONTROLSTATE));
+        bIdleCycles = 0;
+        return false;
+    }
+    if (bIdleCycles < cIDLE_CYCLES) {
+        bIdleCycles++;
+        lIdleKeepAlive = lTimerStart;
+        return false;
+    }
+#if cIDLE_KEEPALIVE
+    if (lTimerStart - lIdleKeepAlive >= cIDLE_KEEPALIVE) {
+        lIdleKeepAlive = lTimerStart;
+        g_ServoDriver.InvalidateShadow();   //in case the SSC-32 lost them
+        return false;
+    }
+#endif
+    g_cIdleCycles++;
+    return true;
+}
+#endif
+
+#ifdef OPT_SSC_MOVESYNC
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+//[MOVESYNC] Waits until the SSC-32 is done with the move, but no longer than wMaxMS
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+void MoveSyncWait(word wMaxMS)
+{
+    unsigned long   ulStart = micros();
+    unsigned long   ulMax = wMaxMS * 1000UL;
+    unsigned long   ulWaited;
+    
+    while (((ulWaited = micros() - ulStart) < ulMax) && !g_ServoDriver.FMoveDone())
+        g_ServoDriver.TxDelay(1);
+    PROF_ADD(cPROF_MOVEWAIT, ulWaited);
+    PROF_ADD(cPROF_MOVESAVED, (ulWaited < ulMax)? ulMax - ulWaited : 0);
+}
+#endif
+
+#ifdef OPT_PROFILE
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+//[PROFILE] Min, max and total time of each stage since the last ProfReset
+//-------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
+PROFSTAGE       g_aProfStages[NUM_PROFSTAGES];
+unsigned long   g_ulProfStart;      //micros() at PROF_BEGIN
+
+void ProfEnd(byte iStage)
+{
+    ProfAdd(iStage, micros() - g_ulProfStart);
+}
+
+void ProfAdd(byte iStage, unsigned long ulTime)
+{
+    PROFSTAGE       *pStage = &g_aProfStages[iStage];
+    word            wTime = (ulTime > 0xffff)? 0xffff : ulTime;
+    
+    if (pStage->cCalls == 0xffff)
+        return;                     //Full, keep the average right
+    if (!pStage->cCalls || (wTime < pStage->wMin))
+        pStage->wMin = wTime;
+    if (wTime > pStage->wMax)
+        pStage->wMax = wTime;
+    pStage->ulSum += ulTime;
+    pStage->cCalls++;
+}
+
+void ProfReset(void)
+{
+    memset(g_aProfStages, 0, sizeof(g_aProfStages));
+#ifdef OPT_IK_CACHE
+    g_cIKCacheLegs = 0;
+    g_cIKCacheHits = 0;
+#endif
+}
+#endif
+
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
 // StartUpdateServos
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
@@ -624,13 +1060,17 @@ void StartUpdateServos()
     // First call off to the init...
     g_ServoDriver.BeginServoUpdate();    // Start the update 
 
+#ifdef OPT_LEGTEMPLATES
+    LEGS_DO(Output);
+#else
     for (LegIndex = 0; LegIndex <= 5; LegIndex++) {
 #ifdef c4DOF
-        g_ServoDriver.OutputServoInfoForLeg(LegIndex, CoxaAngle1[LegIndex], FemurAngle1[LegIndex], TibiaAngle1[LegIndex], sTarsAngle1[LegIndex]);
+        g_ServoDriver.OutputServoInfoForLeg(LegIndex, CoxaAngle1[LegIndex], FemurAngle1[LegIndex], TibiaAngle1[LegIndex], TarsAngle1[LegIndex]);
 #else
         g_ServoDriver.OutputServoInfoForLeg(LegIndex, CoxaAngle1[LegIndex], FemurAngle1[LegIndex], TibiaAngle1[LegIndex]);
 #endif      
     }
+#endif
     
     g_ServoDriver.OutputServoInfoForMandibles(g_InControlState.ManPos.x, g_InControlState.ManPos.y, g_InControlState.ManPos.z, g_InControlState.ManClos.x, g_InControlState.ManClos.y);
     g_ServoDriver.OutputServoInfoForTails(g_InControlState.TailPos.x, g_InControlState.TailPos.y);
@@ -772,97 +1212,103 @@ void TailControl(void)
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
 void GaitSelect(void)
 {
-    //Gait selector
-    switch (g_InControlState.GaitType)  {
-        case 0:
-            //Ripple Gait 12 steps
-            GaitLegNr[cLR] = 1;
-            GaitLegNr[cRF] = 3;
-            GaitLegNr[cLM] = 5;
-            GaitLegNr[cRR] = 7;
-            GaitLegNr[cLF] = 9;
-            GaitLegNr[cRM] = 11;
-            
-            NrLiftedPos = 3;
-            HalfLiftHeigth = 3;
-            TLDivFactor = 8;      
-            StepsInGait = 12;    
-            NomGaitSpeed = 70;
-            break;
-        case 1:
-            //Tripod 8 steps
-            GaitLegNr[cLR] = 5;
-            GaitLegNr[cRF] = 1;
-            GaitLegNr[cLM] = 1;
-            GaitLegNr[cRR] = 1;
-            GaitLegNr[cLF] = 5;
-            GaitLegNr[cRM] = 5;
-                
-            NrLiftedPos = 3;
-            HalfLiftHeigth = 3;
-            TLDivFactor = 4;
-            StepsInGait = 8; 
-            NomGaitSpeed = 70;
-            break;
-        case 2:
-            //Triple Tripod 12 step
-            GaitLegNr[cRF] = 3;
-            GaitLegNr[cLM] = 4;
-            GaitLegNr[cRR] = 5;
-            GaitLegNr[cLF] = 9;
-            GaitLegNr[cRM] = 10;
-            GaitLegNr[cLR] = 11;
-                
-            NrLiftedPos = 3;
-            HalfLiftHeigth = 3;
-            TLDivFactor = 8;
-            StepsInGait = 12; 
-            NomGaitSpeed = 60;
-            break;
-        case 3:
-            // Triple Tripod 16 steps, use 5 lifted positions
-            GaitLegNr[cRF] = 4;
-            GaitLegNr[cLM] = 5;
-            GaitLegNr[cRR] = 6;
-            GaitLegNr[cLF] = 12;
-            GaitLegNr[cRM] = 13;
-            GaitLegNr[cLR] = 14;
-                
-            NrLiftedPos = 5;
-            HalfLiftHeigth = 1;
-            TLDivFactor = 10;
-            StepsInGait = 16; 
-            NomGaitSpeed = 60;
-            break;
-        case 4:
-            //Wave 24 steps
-            GaitLegNr[cLR] = 1;
-            GaitLegNr[cRF] = 21;
-            GaitLegNr[cLM] = 5;
-            
-            GaitLegNr[cRR] = 13;
-            GaitLegNr[cLF] = 9;
-            GaitLegNr[cRM] = 17;
-                
-            NrLiftedPos = 3;
-            HalfLiftHeigth = 3;
-            TLDivFactor = 20;      
-            StepsInGait = 24;        
-            NomGaitSpeed = 70;
-            break;
-    }
+    const GAITDEF   *pGait = &GaitDefs[g_InControlState.GaitType];
+    
+    for (LegIndex = 0; LegIndex <= 5; LegIndex++)
+        GaitLegNr[LegIndex] = pgm_read_byte(&pGait->LegNr[LegIndex]);
+    NrLiftedPos = pgm_read_byte(&pGait->NrLiftedPos);
+    HalfLiftHeigth = pgm_read_byte(&pGait->HalfLiftHeigth);
+    TLDivFactor = pgm_read_byte(&pGait->TLDivFactor);
+    StepsInGait = pgm_read_byte(&pGait->StepsInGait);
+    NomGaitSpeed = pgm_read_byte(&pGait->NomGaitSpeed);
+    pGaitPhases = pGait->Phases;
+    
+    if (NrLiftedPos == 5)
+        LiftDivFactor = 4;    
+    else  
+        LiftDivFactor = 2;
 }    
 
 //--------------------------------------------------------------------
 //[GAIT Sequence]
+#ifdef OPT_GAITPHASE
+// One whole step of the gait for all legs
+void GaitSeqStep(void)
+{
+    LastLeg = 0;
+    for (LegIndex = 0; LegIndex <= 5; LegIndex++) { // for all legs
+        if (LegIndex == 5) // last leg
+            LastLeg = 1 ;
+    
+        Gait(LegIndex);
+    }    // next leg
+}
+
+// The gait runs on time instead of one step per loop: the phase advances by the time since
+// the last cycle over the time of one step.  Whole steps run the gait above, GaitPos is then
+// moved the fraction of the way to the next step.
+void GaitSeq(void)
+{
+    word            wStepTime;      //ms per step
+    unsigned long   lPhase;         //Steps since GaitStep, 1/65536
+    byte            bStep;
+
+    //Check if the Gait is in motion
+    TravelRequest = ((abs(g_InControlState.TravelLength.x)>cTravelDeadZone) || (abs(g_InControlState.TravelLength.z)>cTravelDeadZone) || (abs(g_InControlState.TravelLength.y)>cTravelDeadZone));
+
+    //One step every NomGaitSpeed ms, as the loop paced the gait (it never waits longer than
+    //that); the input delay and speed control only make the servo moves longer
+    wStepTime = NomGaitSpeed;
+    if (wStepTime == 0)
+        wStepTime = 1;
+    if (wGaitPhaseRem >= wStepTime)
+        wGaitPhaseRem = 0;
+
+    //Advance the phase, at most cGAITPHASE_MAXSTEPS steps when the loop stalled
+    lPhase = lTimerStart - lGaitPhaseTime;
+    lGaitPhaseTime = lTimerStart;
+    if (lPhase > (unsigned long)wStepTime*cGAITPHASE_MAXSTEPS)
+        lPhase = (unsigned long)wStepTime*cGAITPHASE_MAXSTEPS;
+    lPhase = (lPhase << 16) + wGaitPhaseRem;
+    wGaitPhaseRem = lPhase % wStepTime;
+    lPhase = (lPhase / wStepTime) + wGaitPhase;
+    wGaitPhase = (word)lPhase;
+
+    //Whole steps, from the positions of the last whole step
+    for (LegIndex = 0; LegIndex <= 5; LegIndex++) {
+        GaitPosX[LegIndex] = GaitStepPosX[LegIndex];
+        GaitPosY[LegIndex] = GaitStepPosY[LegIndex];
+        GaitPosZ[LegIndex] = GaitStepPosZ[LegIndex];
+        GaitRotY[LegIndex] = GaitStepRotY[LegIndex];
+    }
+    for (bStep = (byte)(lPhase >> 16); bStep; bStep--)
+        GaitSeqStep();
+    for (LegIndex = 0; LegIndex <= 5; LegIndex++) {
+        GaitStepPosX[LegIndex] = GaitPosX[LegIndex];
+        GaitStepPosY[LegIndex] = GaitPosY[LegIndex];
+        GaitStepPosZ[LegIndex] = GaitPosZ[LegIndex];
+        GaitStepRotY[LegIndex] = GaitRotY[LegIndex];
+    }
+
+    //Part of the next step: where it puts the legs, then back the rest of the way
+    bStep = wGaitPhase >> 8;
+    if (bStep) {
+        byte bGaitStep = GaitStep;
+        GaitSeqStep();
+        GaitStep = bGaitStep;
+        for (LegIndex = 0; LegIndex <= 5; LegIndex++) {
+            GaitPosX[LegIndex] = GaitStepPosX[LegIndex] + ((GaitPosX[LegIndex] - GaitStepPosX[LegIndex]) * bStep) / 256;
+            GaitPosY[LegIndex] = GaitStepPosY[LegIndex] + ((GaitPosY[LegIndex] - GaitStepPosY[LegIndex]) * bStep) / 256;
+            GaitPosZ[LegIndex] = GaitStepPosZ[LegIndex] + ((GaitPosZ[LegIndex] - GaitStepPosZ[LegIndex]) * bStep) / 256;
+            GaitRotY[LegIndex] = GaitStepRotY[LegIndex] + ((GaitRotY[LegIndex] - GaitStepRotY[LegIndex]) * bStep) / 256;
+        }
+    }
+}
+#else
 void GaitSeq(void)
 {
     //Check if the Gait is in motion
     TravelRequest = ((abs(g_InControlState.TravelLength.x)>cTravelDeadZone) || (abs(g_InControlState.TravelLength.z)>cTravelDeadZone) || (abs(g_InControlState.TravelLength.y)>cTravelDeadZone));
-    if (NrLiftedPos == 5)
-  	LiftDivFactor = 4;    
-    else  
- 	LiftDivFactor = 2;
 
    //Calculate Gait sequence
     LastLeg = 0;
@@ -873,77 +1319,98 @@ void GaitSeq(void)
         Gait(LegIndex);
     }    // next leg
 }
+#endif
 
 
 //--------------------------------------------------------------------
 //[GAIT]
 void Gait (byte GaitCurrentLegNr)
 {
+    byte    bPhase;         //Steps since the lift step of this leg
+    byte    bAction;        //cGaitXxx
+    
     //Clear values under the cTravelDeadZone
     if (!TravelRequest) {    
         g_InControlState.TravelLength.x=0;
         g_InControlState.TravelLength.z=0;
         g_InControlState.TravelLength.y=0;
     }
+    //Action for the steps since this leg was lifted
+    bPhase = GaitStep + StepsInGait - GaitLegNr[GaitCurrentLegNr];
+    if (bPhase >= StepsInGait)
+        bPhase -= StepsInGait;
+    bAction = pgm_read_byte(&pGaitPhases[bPhase]);
+    if (TravelRequest)
+        bAction &= 0x0f;
+    else {
+        bAction >>= 4;
+        //Gait NOT in motion, return to home position
+        if ((bAction == cGaitUpHome) && !((abs(GaitPosX[GaitCurrentLegNr])>2) || 
+                (abs(GaitPosZ[GaitCurrentLegNr])>2) || (abs(GaitRotY[GaitCurrentLegNr])>2)))
+            bAction = cGaitPush;
+    }
+
+    switch (bAction) {
     //Leg middle up position
-    //Gait in motion														  									Gait NOT in motion, return to home position
-    if ((TravelRequest && (NrLiftedPos==1 || NrLiftedPos==3 || NrLiftedPos==5) && 
-            GaitStep==GaitLegNr[GaitCurrentLegNr]) || (!TravelRequest && GaitStep==GaitLegNr[GaitCurrentLegNr] && ((abs(GaitPosX[GaitCurrentLegNr])>2) || 
-                (abs(GaitPosZ[GaitCurrentLegNr])>2) || (abs(GaitRotY[GaitCurrentLegNr])>2)))) { //Up
+    case cGaitUp:
+    case cGaitUpHome:
         GaitPosX[GaitCurrentLegNr] = 0;
         GaitPosY[GaitCurrentLegNr] = -g_InControlState.LegLiftHeight;
         GaitPosZ[GaitCurrentLegNr] = 0;
         GaitRotY[GaitCurrentLegNr] = 0;
-    }
+        break;
+
     //Optional Half heigth Rear (2, 3, 5 lifted positions)
-    else if (((NrLiftedPos==2 && GaitStep==GaitLegNr[GaitCurrentLegNr]) || (NrLiftedPos>=3 && 
-            (GaitStep==GaitLegNr[GaitCurrentLegNr]-1 || GaitStep==GaitLegNr[GaitCurrentLegNr]+(StepsInGait-1))))
-            && TravelRequest) {
+    case cGaitHalfRear:
         GaitPosX[GaitCurrentLegNr] = -g_InControlState.TravelLength.x/LiftDivFactor;
         GaitPosY[GaitCurrentLegNr] = -3*g_InControlState.LegLiftHeight/(3+HalfLiftHeigth);     //Easier to shift between div factor: /1 (3/3), /2 (3/6) and 3/4
         GaitPosZ[GaitCurrentLegNr] = -g_InControlState.TravelLength.z/LiftDivFactor;
         GaitRotY[GaitCurrentLegNr] = -g_InControlState.TravelLength.y/LiftDivFactor;
-    }    
+        break;
   	  
     // Optional Half heigth front (2, 3, 5 lifted positions)
-    else if ((NrLiftedPos>=2) && (GaitStep==GaitLegNr[GaitCurrentLegNr]+1 || GaitStep==GaitLegNr[GaitCurrentLegNr]-(StepsInGait-1)) && TravelRequest) {
+    case cGaitHalfFront:
         GaitPosX[GaitCurrentLegNr] = g_InControlState.TravelLength.x/LiftDivFactor;
         GaitPosY[GaitCurrentLegNr] = -3*g_InControlState.LegLiftHeight/(3+HalfLiftHeigth); // Easier to shift between div factor: /1 (3/3), /2 (3/6) and 3/4
         GaitPosZ[GaitCurrentLegNr] = g_InControlState.TravelLength.z/LiftDivFactor;
         GaitRotY[GaitCurrentLegNr] = g_InControlState.TravelLength.y/LiftDivFactor;
-    }
+        break;
 
     //Optional Half heigth Rear 5 LiftedPos (5 lifted positions)
-    else if (((NrLiftedPos==5 && (GaitStep==GaitLegNr[GaitCurrentLegNr]-2 ))) && TravelRequest) {
-	GaitPosX[GaitCurrentLegNr] = -g_InControlState.TravelLength.x/2;
+    case cGaitRear2:
+        GaitPosX[GaitCurrentLegNr] = -g_InControlState.TravelLength.x/2;
         GaitPosY[GaitCurrentLegNr] = -g_InControlState.LegLiftHeight/2;
         GaitPosZ[GaitCurrentLegNr] = -g_InControlState.TravelLength.z/2;
         GaitRotY[GaitCurrentLegNr] = -g_InControlState.TravelLength.y/2;
-     }  		
+        break;
 
     //Optional Half heigth Front 5 LiftedPos (5 lifted positions)
-    else if ((NrLiftedPos==5) && (GaitStep==GaitLegNr[GaitCurrentLegNr]+2 || GaitStep==GaitLegNr[GaitCurrentLegNr]-(StepsInGait-2)) && TravelRequest) {
+    case cGaitFront2:
         GaitPosX[GaitCurrentLegNr] = g_InControlState.TravelLength.x/2;
         GaitPosY[GaitCurrentLegNr] = -g_InControlState.LegLiftHeight/2;
         GaitPosZ[GaitCurrentLegNr] = g_InControlState.TravelLength.z/2;
         GaitRotY[GaitCurrentLegNr] = g_InControlState.TravelLength.y/2;
-    }
-
-  //Leg front down position
-  else if ((GaitStep==GaitLegNr[GaitCurrentLegNr]+NrLiftedPos || GaitStep==GaitLegNr[GaitCurrentLegNr]-(StepsInGait-NrLiftedPos))
-            && GaitPosY[GaitCurrentLegNr]<0) {
-        GaitPosX[GaitCurrentLegNr] = g_InControlState.TravelLength.x/2;
-        GaitPosZ[GaitCurrentLegNr] = g_InControlState.TravelLength.z/2;
-        GaitRotY[GaitCurrentLegNr] = g_InControlState.TravelLength.y/2;      	
-        GaitPosY[GaitCurrentLegNr] = 0;	//Only move leg down at once if terrain adaption is turned off
-    }
+        break;
+
+    //Leg front down position
+    case cGaitDown:
+        if (GaitPosY[GaitCurrentLegNr]<0) {
+            GaitPosX[GaitCurrentLegNr] = g_InControlState.TravelLength.x/2;
+            GaitPosZ[GaitCurrentLegNr] = g_InControlState.TravelLength.z/2;
+            GaitRotY[GaitCurrentLegNr] = g_InControlState.TravelLength.y/2;      	
+            GaitPosY[GaitCurrentLegNr] = 0;	//Only move leg down at once if terrain adaption is turned off
+            break;
+        }
+        //Already down, keep moving with the body
+        // fall through
 
     //Move body forward      
-    else {
+    default:
         GaitPosX[GaitCurrentLegNr] = GaitPosX[GaitCurrentLegNr] - (g_InControlState.TravelLength.x/TLDivFactor);
         GaitPosY[GaitCurrentLegNr] = 0; 
         GaitPosZ[GaitCurrentLegNr] = GaitPosZ[GaitCurrentLegNr] - (g_InControlState.TravelLength.z/TLDivFactor);
         GaitRotY[GaitCurrentLegNr] = GaitRotY[GaitCurrentLegNr] - (g_InControlState.TravelLength.y/TLDivFactor);
+        break;
     }
    
 
@@ -964,7 +1431,9 @@ void BalCalcOneLeg (short PosX, short PosZ, short PosY, byte BalLegNr)
     short            CPR_X;            //Final X value for centerpoint of rotation
     short            CPR_Y;            //Final Y value for centerpoint of rotation
     short            CPR_Z;            //Final Z value for centerpoint of rotation
-    long             lAtan;
+#ifdef OPT_BALANCE_CACHE
+    BALLEG           *pBalLeg = &g_aBalLegs[BalLegNr];
+#endif
 
     //Calculating totals from center of the body to the feet
     CPR_Z = (short)pgm_read_word(&cOffsetZ[BalLegNr]) + PosZ;
@@ -975,16 +1444,71 @@ void BalCalcOneLeg (short PosX, short PosZ, short PosY, byte BalLegNr)
     TotalTransZ += (long)CPR_Z;
     TotalTransX += (long)CPR_X;
     
-    lAtan = GetATan2(CPR_X, CPR_Z);
-    TotalYBal1 += (lAtan*1800) / 31415;
+#ifdef OPT_BALANCE_CACHE
+    //Only work the angles out again when the leg moved
+    if (!pBalLeg->fValid || (PosX != pBalLeg->PosX) || (PosZ != pBalLeg->PosZ) || (PosY != pBalLeg->PosY)) {
+        pBalLeg->PosX = PosX;
+        pBalLeg->PosZ = PosZ;
+        pBalLeg->PosY = PosY;
+        pBalLeg->YBal1 = BalATan2Deg1(CPR_X, CPR_Z);
+        pBalLeg->ZBal1 = BalATan2Deg1(CPR_X, CPR_Y) - 900; //Rotate balance circle 90 deg
+        pBalLeg->XBal1 = BalATan2Deg1(CPR_Z, CPR_Y) - 900; //Rotate balance circle 90 deg
+        pBalLeg->fValid = true;
+        g_fBalChanged = true;
+    }
+    TotalYBal1 += pBalLeg->YBal1;
+    TotalZBal1 += pBalLeg->ZBal1;
+    TotalXBal1 += pBalLeg->XBal1;
+#else
+    TotalYBal1 += BalATan2Deg1(CPR_X, CPR_Z);
     
-    lAtan = GetATan2 (CPR_X, CPR_Y);
-    TotalZBal1 += ((lAtan*1800) / 31415) -900; //Rotate balance circle 90 deg
+    TotalZBal1 += BalATan2Deg1(CPR_X, CPR_Y) - 900; //Rotate balance circle 90 deg
     
-    lAtan = GetATan2 (CPR_Z, CPR_Y);
-    TotalXBal1 += ((lAtan*1800) / 31415) - 900; //Rotate balance circle 90 deg
+    TotalXBal1 += BalATan2Deg1(CPR_Z, CPR_Y) - 900; //Rotate balance circle 90 deg
+#endif
+}
+
 
+//--------------------------------------------------------------------
+//[BalATan2Deg1] ArcTan2 for the balance, in degrees
+//AtanX         - Input X
+//AtanY         - Input Y
+//returns       - ARCTAN2(X/Y) in degrees, decimals = 1
+#ifdef OPT_BALANCE_FASTATAN
+//The balance has no use for the hypotenuse, so no isqrt32 and no ArcCos: on the first
+//octant atan(r) ~ r*(45 + 15.64*(1-r)) degrees (off by 0.3 at most), the rest by symmetry.
+short BalATan2Deg1 (short AtanX, short AtanY)
+{
+    word    wX = (AtanX < 0)? -AtanX : AtanX;
+    word    wY = (AtanY < 0)? -AtanY : AtanY;
+    word    wR;                 //smaller over larger of the two, 4096 = 1
+    short   Deg1;
+
+    if (wX >= wY) {
+        if (!wX)
+            return 0;
+        wR = ((unsigned long)wY << 12) / wX;
+    } else
+        wR = ((unsigned long)wX << 12) / wY;
+
+    //In 1/16 of a 0.1 degree: 7200 is 45 degrees, 2502 the 15.64
+    Deg1 = ((unsigned long)wR * (7200 + ((2502UL * (4096 - wR)) >> 12)) + 0x8000) >> 16;
+    if (wX < wY)
+        Deg1 = 900 - Deg1;
+    if (AtanX < 0)
+        Deg1 = 1800 - Deg1;
+    return (AtanY < 0)? -Deg1 : Deg1;
+}
+#else
+short BalATan2Deg1 (short AtanX, short AtanY)
+{
+#ifdef OPT_FIXEDPOINT
+    return Rad4ToDeg1(GetATan2(AtanX, AtanY).atan4);
+#else
+    return ((long)GetATan2(AtanX, AtanY).atan4 * 1800) / 31415;
+#endif
 }
+#endif
 
 
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
@@ -992,6 +1516,19 @@ void BalCalcOneLeg (short PosX, short PosZ, short PosY, byte BalLegNr)
 //-------------------------------------------------------------------------------------------------------------------------------------------------------------------------------------
 void BalanceBody(void)
 {
+#ifdef OPT_BALANCE_CACHE
+    //No leg moved, so the totals and what they come to are the same as last time
+    if (!g_fBalChanged) {
+        TotalTransX = g_BalBody.TransX;
+        TotalTransZ = g_BalBody.TransZ;
+        TotalTransY = g_BalBody.TransY;
+        TotalXBal1 = g_BalBody.XBal1;
+        TotalYBal1 = g_BalBody.YBal1;
+        TotalZBal1 = g_BalBody.ZBal1;
+        return;
+    }
+    g_fBalChanged = false;
+#endif
     TotalTransZ = TotalTransZ/BalanceDivFactor ;
     TotalTransX = TotalTransX/BalanceDivFactor;
     TotalTransY = TotalTransY/BalanceDivFactor;
@@ -1011,20 +1548,42 @@ void BalanceBody(void)
     TotalYBal1 = -TotalYBal1/BalanceDivFactor;
     TotalXBal1 = -TotalXBal1/BalanceDivFactor;
     TotalZBal1 = TotalZBal1/BalanceDivFactor;
+#ifdef OPT_BALANCE_CACHE
+    g_BalBody.TransX = TotalTransX;
+    g_BalBody.TransZ = TotalTransZ;
+    g_BalBody.TransY = TotalTransY;
+    g_BalBody.XBal1 = TotalXBal1;
+    g_BalBody.YBal1 = TotalYBal1;
+    g_BalBody.ZBal1 = TotalZBal1;
+#endif
 }
 
 
+//--------------------------------------------------------------------
+//(SINTAB) Sinus of 0 to 90 deg from the table
+//Angle1        - Input Angle in degrees, decimals = 1
+//returns       - Sinus, times cSINCOS_ONE
+static inline short SinTab(short Angle1)
+{
+#ifdef OPT_TRIGTABLES
+    return TRIGSINCFG::Lookup<TRIGPGM<TRIGSINCFG> >(Angle1);
+#else
+    return pgm_read_word(&GetSin[Angle1/5]);     // 5 is the presision (0.5) of the table
+#endif
+}
+
 //--------------------------------------------------------------------
 //[GETSINCOS] Get the sinus and cosinus from the angle +/- multiple circles
 //AngleDeg1     - Input Angle in degrees
-//sin4        - Output Sinus of AngleDeg
-//cos4          - Output Cosinus of AngleDeg
-void GetSinCos(short AngleDeg1)
+//returns .sin4 - Sinus of AngleDeg
+//        .cos4 - Cosinus of AngleDeg
+SINCOS GetSinCos(short AngleDeg1)
 {
-    short        ABSAngleDeg1;    //Absolute value of the Angle in Degrees, decimals = 1
+    SINCOS       SinCos;
+    long         ABSAngleDeg1;    //Absolute value of the Angle in Degrees, decimals = 1 (long so -32768 works)
     //Get the absolute value of AngleDeg
     if (AngleDeg1 < 0)
-        ABSAngleDeg1 = AngleDeg1 *-1;
+        ABSAngleDeg1 = (long)AngleDeg1 *-1;
     else
           ABSAngleDeg1 = AngleDeg1;
     
@@ -1036,34 +1595,48 @@ void GetSinCos(short AngleDeg1)
     
     if (AngleDeg1>=0 && AngleDeg1<=900)     // 0 to 90 deg
     {
-        sin4 = pgm_read_word(&GetSin[AngleDeg1/5]);             // 5 is the presision (0.5) of the table
-        cos4 = pgm_read_word(&GetSin[(900-(AngleDeg1))/5]);
+        SinCos.sin4 = SinTab(AngleDeg1);
+        SinCos.cos4 = SinTab(900-(AngleDeg1));
     }     
         
     else if (AngleDeg1>900 && AngleDeg1<=1800)     // 90 to 180 deg
     {
-        sin4 = pgm_read_word(&GetSin[(900-(AngleDeg1-900))/5]); // 5 is the presision (0.5) of the table    
-        cos4 = -pgm_read_word(&GetSin[(AngleDeg1-900)/5]);            
+        SinCos.sin4 = SinTab(900-(AngleDeg1-900));
+        SinCos.cos4 = -SinTab(AngleDeg1-900);
     }    
     else if (AngleDeg1>1800 && AngleDeg1<=2700) // 180 to 270 deg
     {
-        sin4 = -pgm_read_word(&GetSin[(AngleDeg1-1800)/5]);     // 5 is the presision (0.5) of the table
-        cos4 = -pgm_read_word(&GetSin[(2700-AngleDeg1)/5]);
+        SinCos.sin4 = -SinTab(AngleDeg1-1800);
+        SinCos.cos4 = -SinTab(2700-AngleDeg1);
     }    
 
     else if(AngleDeg1>2700 && AngleDeg1<=3600) // 270 to 360 deg
     {
-        sin4 = -pgm_read_word(&GetSin[(3600-AngleDeg1)/5]); // 5 is the presision (0.5) of the table    
-        cos4 = pgm_read_word(&GetSin[(AngleDeg1-2700)/5]);            
+        SinCos.sin4 = -SinTab(3600-AngleDeg1);
+        SinCos.cos4 = SinTab(AngleDeg1-2700);
     }
+    return SinCos;
 }    
 
+#ifdef OPT_CORDIC_ATAN2
+//--------------------------------------------------------------------
+//(GETARCCOS) ArcCos as the angle of the vector (cos, sin), see GetATan2
+//cos4        - Input Cosinus
+//returns       - Angle in radians, decimals = 4
+long GetArcCos(short cos4)
+{
+    long    lCos4 = constrain((long)cos4, -c4DEC, c4DEC);
+    
+    return GetATan2(lCos4, isqrt32((long)c4DEC*c4DEC - lCos4*lCos4)).atan4;
+}
+#else
 //--------------------------------------------------------------------
 //(GETARCCOS) Get the sinus and cosinus from the angle +/- multiple circles
 //cos4        - Input Cosinus
-//AngleRad4     - Output Angle in AngleRad4
+//returns       - Angle in radians, decimals = 4
 long GetArcCos(short cos4)
 {
+    short   AngleRad4 = 0;          //Angle in radians, decimals = 4 (cos4 = -32768 falls through to acos(-1))
     boolean NegativeValue/*:1*/;    //If the the value is Negative
     //Check for negative value
     if (cos4<0)
@@ -1077,6 +1650,10 @@ long GetArcCos(short cos4)
     //Limit cos4 to his maximal value
     cos4 = min(cos4,c4DEC);
     
+#ifdef OPT_TRIGTABLES
+    if (cos4>=0)
+        AngleRad4 = TRIGACOSCFG::Lookup<TRIGPGM<TRIGACOSCFG> >(cos4);
+#else
     if ((cos4>=0) && (cos4<9000))
     {
         AngleRad4 = (byte)pgm_read_byte(&GetACos[cos4/79]);
@@ -1092,6 +1669,7 @@ long GetArcCos(short cos4)
         AngleRad4 = (byte)pgm_read_byte(&GetACos[(cos4-9900)/2+227]);
         AngleRad4 = (long)((long)AngleRad4*616)/c1DEC;             //616=acos resolution (pi/2/255) 
     }
+#endif
        
     //Add negative sign
     if (NegativeValue)
@@ -1099,6 +1677,7 @@ long GetArcCos(short cos4)
 
     return AngleRad4;
 }    
+#endif
 
 unsigned long isqrt32 (unsigned long n) //
 {
@@ -1126,100 +1705,331 @@ unsigned long isqrt32 (unsigned long n) //
 }
 
 
+#ifdef OPT_CORDIC_ATAN2
+//--------------------------------------------------------------------
+//(GETATAN2) ArcTan2 and hypotenuse in one CORDIC pass: the vector is rotated
+//onto the X axis in steps of ArcTan(2^-i), using only shifts and adds.  Its
+//length is then the hypotenuse, times the CORDIC gain.
+//ArcTanX         - Input X
+//ArcTanY         - Input Y
+//returns .atan4    - ARCTAN2(X/Y)
+//        .hyp2     - Hypotenuse of X and Y
+ATAN2 GetATan2 (short AtanX, short AtanY)
+{
+    ATAN2   ATan2;
+    long    lX = AtanX;
+    long    lY = AtanY;
+    long    lXs;
+    long    lAngle;         //Angle in radians, decimals = 4, times 64
+    long    lMax;
+    byte    bShift;
+    byte    i;
+
+    if ((lX == 0) && (lY == 0)) {
+        ATan2.atan4 = 0;
+        ATan2.hyp2 = 0;
+        return ATan2;
+    }
+
+    //Start in the right half, the rotations below only reach +/- 99 deg
+    lAngle = 0;
+    if (lX < 0) {
+        lAngle = (lY < 0)? -cCordicPI : cCordicPI;
+        lX = -lX;
+        lY = -lY;
+    }
+    
+    //Use 23 bits for the vector, leaves room for the gain of 1.65 * sqrt(2)
+    lMax = max(lX, abs(lY));
+    for (bShift = 0; lMax < 0x400000L; bShift++)
+        lMax <<= 1;
+    lX <<= bShift;
+    lY <<= bShift;
+
+    for (i = 0; i < cCORDIC_ITERATIONS; i++) {
+        lXs = lX >> i;
+        if (lY > 0) {
+            lX += lY >> i;
+            lY -= lXs;
+            lAngle += (long)pgm_read_dword(&GetCordicAtan[i]);
+        } else {
+            lX -= lY >> i;
+            lY += lXs;
+            lAngle -= (long)pgm_read_dword(&GetCordicAtan[i]);
+        }
+    }
+    ATan2.atan4 = (lAngle + 32) >> 6;
+
+    //Remove the gain (lX * 1/K in two halves to stay in 32 bits) and the shift
+    lX = (lX >> 16) * cCordicInvK16 + (((unsigned long)(lX & 0xffff) * cCordicInvK16) >> 16);
+    ATan2.hyp2 = (lX*c2DEC + (1L << (bShift-1))) >> bShift;
+    return ATan2;
+}    
+#else
 //--------------------------------------------------------------------
 //(GETATAN2) Simplyfied ArcTan2 function based on fixed point ArcCos
 //ArcTanX         - Input X
 //ArcTanY         - Input Y
-//ArcTan4          - Output ARCTAN2(X/Y)
-//XYhyp2            - Output presenting Hypotenuse of X and Y
-short GetATan2 (short AtanX, short AtanY)
+//returns .atan4    - ARCTAN2(X/Y)
+//        .hyp2     - Hypotenuse of X and Y
+ATAN2 GetATan2 (short AtanX, short AtanY)
 {
-    XYhyp2 = isqrt32(((long)AtanX*AtanX*c4DEC) + ((long)AtanY*AtanY*c4DEC));
-    GetArcCos (((long)AtanX*(long)c6DEC) /(long) XYhyp2);
+    ATAN2   ATan2;
+    short   AngleRad4;
+    
+    ATan2.hyp2 = isqrt32(((long)AtanX*AtanX*c4DEC) + ((long)AtanY*AtanY*c4DEC));
+    AngleRad4 = GetArcCos (((long)AtanX*(long)c6DEC) /(long) ATan2.hyp2);
     
     if (AtanY < 0)                // removed overhead... Atan4 = AngleRad4 * (AtanY/abs(AtanY));  
-        Atan4 = -AngleRad4;
+        ATan2.atan4 = -AngleRad4;
     else
-        Atan4 = AngleRad4;
-    return Atan4;
+        ATan2.atan4 = AngleRad4;
+    return ATan2;
 }    
     
+#endif
+    
+#ifdef OPT_FIXEDPOINT
+//--------------------------------------------------------------------
+//(RAD4TODEG1) Angle in radians, decimals = 4, to degrees, decimals = 1: times
+//1800/31416, which is 3755/65536 to 16 bits, so a multiply and a shift
+short Rad4ToDeg1 (long Rad4)
+{
+    return (QINT::Raw(Rad4) * QNUM<16>::Raw(3755)).ToInt();
+}
+#endif
+
+//--------------------------------------------------------------------
+//[BODY ROTATION] Updates the sinus and cosinus of the body rotation for BodyFK.
+//The lookups are only done for the angles that changed.
+//RotX1             - Input pitch of the body, with balance
+//RotY1             - Input rotation of the body, with balance
+//RotZ1             - Input roll of the body, with balance
+void BodyRotUpdate (BODYROT *pBodyRot, short RotX1, long RotY1, short RotZ1)
+{
+    if (RotX1 != pBodyRot->RotX1) {
+        pBodyRot->RotX1 = RotX1;
+        pBodyRot->G = GetSinCos(RotX1);
+    }
+    if (RotZ1 != pBodyRot->RotZ1) {
+        pBodyRot->RotZ1 = RotZ1;
+        pBodyRot->B = GetSinCos(RotZ1);
+    }
+    pBodyRot->RotY1 = RotY1;
+    pBodyRot->fNoTilt = (pBodyRot->G.sin4 == 0) && (pBodyRot->G.cos4 == cSINCOS_ONE) 
+            && (pBodyRot->B.sin4 == 0) && (pBodyRot->B.cos4 == cSINCOS_ONE);
+}
+
 //--------------------------------------------------------------------
 //(BODY INVERSE KINEMATICS) 
-//BodyRotX         - Global Input pitch of the body 
-//BodyRotY         - Global Input rotation of the body 
-//BodyRotZ         - Global Input roll of the body 
+//pBodyRot          - Input sin/cos of the body rotation (BodyRotUpdate)
 //RotationY         - Input Rotation for the gait 
 //PosX            - Input position of the feet X 
 //PosZ            - Input position of the feet Z 
-//SinB                  - Sin buffer for BodyRotX
-//CosB               - Cos buffer for BodyRotX
-//SinG                  - Sin buffer for BodyRotZ
-//CosG               - Cos buffer for BodyRotZ
-//BodyFKPosX         - Output Position X of feet with Rotation 
-//BodyFKPosY         - Output Position Y of feet with Rotation 
-//BodyFKPosZ         - Output Position Z of feet with Rotation
-void BodyFK (short PosX, short PosZ, short PosY, short RotationY, byte BodyIKLeg) 
+//returns .x         - Position X of feet with Rotation 
+//        .y         - Position Y of feet with Rotation 
+//        .z         - Position Z of feet with Rotation
+COORD3D BodyFK (BODYROT *pBodyRot, short PosX, short PosZ, short PosY, short RotationY, byte BodyIKLeg) 
 {
-    short            SinA4;          //Sin buffer for BodyRotX calculations
-    short            CosA4;          //Cos buffer for BodyRotX calculations
-    short            SinB4;          //Sin buffer for BodyRotX calculations
-    short            CosB4;          //Cos buffer for BodyRotX calculations
-    short            SinG4;          //Sin buffer for BodyRotZ calculations
-    short            CosG4;          //Cos buffer for BodyRotZ calculations
-    short            CPR_X;            //Final X value for centerpoint of rotation
-    short            CPR_Y;            //Final Y value for centerpoint of rotation
-    short            CPR_Z;            //Final Z value for centerpoint of rotation
-
     //Calculating totals from center of the body to the feet 
-    CPR_X = (short)pgm_read_word(&cOffsetX[BodyIKLeg])+PosX + BodyRotOffsetX;
-    CPR_Y = PosY + BodyRotOffsetY;         //Define centerpoint for rotation along the Y-axis
-    CPR_Z = (short)pgm_read_word(&cOffsetZ[BodyIKLeg]) + PosZ + BodyRotOffsetZ;
+    return BodyFKCPR(pBodyRot, (short)pgm_read_word(&cOffsetX[BodyIKLeg])+PosX + BodyRotOffsetX,
+            (short)pgm_read_word(&cOffsetZ[BodyIKLeg]) + PosZ + BodyRotOffsetZ, PosY + BodyRotOffsetY, RotationY);
+}
+
+//--------------------------------------------------------------------
+//(BODY INVERSE KINEMATICS) BodyFK from the centerpoint of rotation to the feet
+//CPR_X, CPR_Z, CPR_Y - Input feet position from the center of the body, with the
+//                      BodyRotOffset
+//--------------------------------------------------------------------
+COORD3D BodyFKCPR (BODYROT *pBodyRot, short CPR_X, short CPR_Z, short CPR_Y, short RotationY)
+{
+    COORD3D          BodyFKPos;
+    short            SinA4;          //Sin buffer for BodyRotY calculations
+    short            CosA4;          //Cos buffer for BodyRotY calculations
+    short            SinB4;          //Sin buffer for BodyRotZ calculations
+    short            CosB4;          //Cos buffer for BodyRotZ calculations
+    short            SinG4;          //Sin buffer for BodyRotX calculations
+    short            CosG4;          //Cos buffer for BodyRotX calculations
+    short            AngleA1;
+
+#ifdef OPT_FIXEDPOINT
+    //In 1/64 mm; each Mul by a sin or cos is back in 1/64 mm by a shift
+    QPOS    X = QPOS::Int(CPR_X);
+    QPOS    Y = QPOS::Int(CPR_Y);
+    QPOS    Z = QPOS::Int(CPR_Z);
+#endif
 
     //Successive global rotation matrix: 
-    //Math shorts for rotation: Alfa [A] = Xrotate, Beta [B] = Zrotate, Gamma [G] = Yrotate 
+    //Math shorts for rotation: Alfa [A] = Yrotate, Beta [B] = Zrotate, Gamma [G] = Xrotate 
     //Sinus Alfa = SinA, cosinus Alfa = cosA. and so on... 
     
-    //First calculate sinus and cosinus for each rotation: 
-    GetSinCos (g_InControlState.BodyRot1.x+TotalXBal1);
-    SinG4 = sin4;
-    CosG4 = cos4;
-    
-    GetSinCos (g_InControlState.BodyRot1.z+TotalZBal1); 
-    SinB4 = sin4;
-    CosB4 = cos4;
-    
-    GetSinCos (g_InControlState.BodyRot1.y+(RotationY*c1DEC)+TotalYBal1) ;
-    SinA4 = sin4;
-    CosA4 = cos4;
+    //The Y rotation includes the gait rotation of this leg; legs in the same
+    //phase of the gait have the same one, so reuse the last lookup
+    AngleA1 = pBodyRot->RotY1+(RotationY*c1DEC);
+    if (AngleA1 != pBodyRot->LegRotY1) {
+        pBodyRot->LegRotY1 = AngleA1;
+        pBodyRot->A = GetSinCos(AngleA1);
+    }
+    SinA4 = pBodyRot->A.sin4;
+    CosA4 = pBodyRot->A.cos4;
+
+    if (pBodyRot->fNoTilt) {
+        //Only a Y rotation: the matrix below with sin = 0, cos = 1 for X and Z,
+        //which gives exactly the same result
+        if ((SinA4 == 0) && (CosA4 == cSINCOS_ONE)) {
+            BodyFKPos.x = 0;
+            BodyFKPos.y = 0;
+            BodyFKPos.z = 0;
+        } else {
+#ifdef OPT_FIXEDPOINT
+            QSIN    SinA = QSIN::Raw(SinA4);
+            QSIN    CosA = QSIN::Raw(CosA4);
+            BodyFKPos.x = CPR_X - (X.Mul(CosA) - Z.Mul(SinA)).ToInt();
+            BodyFKPos.z = CPR_Z - (X.Mul(SinA) + Z.Mul(CosA)).ToInt();
+#else
+            BodyFKPos.x = ((long)CPR_X*c2DEC - ((long)CPR_X*c2DEC*CosA4/c4DEC - (long)CPR_Z*c2DEC*SinA4/c4DEC))/c2DEC;
+            BodyFKPos.z = ((long)CPR_Z*c2DEC - ((long)CPR_X*c2DEC*SinA4/c4DEC + (long)CPR_Z*c2DEC*CosA4/c4DEC))/c2DEC;
+#endif
+            BodyFKPos.y = 0;
+        }
+        return BodyFKPos;
+    }
+    SinB4 = pBodyRot->B.sin4;
+    CosB4 = pBodyRot->B.cos4;
+    SinG4 = pBodyRot->G.sin4;
+    CosG4 = pBodyRot->G.cos4;
     
     //Calcualtion of rotation matrix: 
-      BodyFKPosX = ((long)CPR_X*c2DEC - ((long)CPR_X*c2DEC*CosA4/c4DEC*CosB4/c4DEC - (long)CPR_Z*c2DEC*CosB4/c4DEC*SinA4/c4DEC 
+#ifdef OPT_FIXEDPOINT
+    {
+        QSIN    SinA = QSIN::Raw(SinA4);
+        QSIN    CosA = QSIN::Raw(CosA4);
+        QSIN    SinB = QSIN::Raw(SinB4);
+        QSIN    CosB = QSIN::Raw(CosB4);
+        QSIN    SinG = QSIN::Raw(SinG4);
+        QSIN    CosG = QSIN::Raw(CosG4);
+
+        BodyFKPos.x = CPR_X - (X.Mul(CosA).Mul(CosB) - Z.Mul(CosB).Mul(SinA) + Y.Mul(SinB)).ToInt();
+        BodyFKPos.z = CPR_Z - (X.Mul(CosG).Mul(SinA) + X.Mul(CosA).Mul(SinB).Mul(SinG)
+                + Z.Mul(CosA).Mul(CosG) - Z.Mul(SinA).Mul(SinB).Mul(SinG)
+                - Y.Mul(CosB).Mul(SinG)).ToInt();
+        BodyFKPos.y = CPR_Y - (X.Mul(SinA).Mul(SinG) - X.Mul(CosA).Mul(CosG).Mul(SinB)
+                + Z.Mul(CosA).Mul(SinG) + Z.Mul(CosG).Mul(SinA).Mul(SinB)
+                + Y.Mul(CosB).Mul(CosG)).ToInt();
+    }
+#else
+      BodyFKPos.x = ((long)CPR_X*c2DEC - ((long)CPR_X*c2DEC*CosA4/c4DEC*CosB4/c4DEC - (long)CPR_Z*c2DEC*CosB4/c4DEC*SinA4/c4DEC 
               + (long)CPR_Y*c2DEC*SinB4/c4DEC ))/c2DEC;
-      BodyFKPosZ = ((long)CPR_Z*c2DEC - ( (long)CPR_X*c2DEC*CosG4/c4DEC*SinA4/c4DEC + (long)CPR_X*c2DEC*CosA4/c4DEC*SinB4/c4DEC*SinG4/c4DEC 
+      BodyFKPos.z = ((long)CPR_Z*c2DEC - ( (long)CPR_X*c2DEC*CosG4/c4DEC*SinA4/c4DEC + (long)CPR_X*c2DEC*CosA4/c4DEC*SinB4/c4DEC*SinG4/c4DEC 
               + (long)CPR_Z*c2DEC*CosA4/c4DEC*CosG4/c4DEC - (long)CPR_Z*c2DEC*SinA4/c4DEC*SinB4/c4DEC*SinG4/c4DEC 
               - (long)CPR_Y*c2DEC*CosB4/c4DEC*SinG4/c4DEC ))/c2DEC;
-      BodyFKPosY = ((long)CPR_Y  *c2DEC - ( (long)CPR_X*c2DEC*SinA4/c4DEC*SinG4/c4DEC - (long)CPR_X*c2DEC*CosA4/c4DEC*CosG4/c4DEC*SinB4/c4DEC 
+      BodyFKPos.y = ((long)CPR_Y  *c2DEC - ( (long)CPR_X*c2DEC*SinA4/c4DEC*SinG4/c4DEC - (long)CPR_X*c2DEC*CosA4/c4DEC*CosG4/c4DEC*SinB4/c4DEC 
               + (long)CPR_Z*c2DEC*CosA4/c4DEC*SinG4/c4DEC + (long)CPR_Z*c2DEC*CosG4/c4DEC*SinA4/c4DEC*SinB4/c4DEC 
               + (long)CPR_Y*c2DEC*CosB4/c4DEC*CosG4/c4DEC ))/c2DEC;
+#endif
+    return BodyFKPos;
 }  
 
 
 
+//--------------------------------------------------------------------
+//[INIT LEG IK CONSTANTS] Fills LegIKConst from the leg configuration
+//--------------------------------------------------------------------
+void InitLegIKConst (void)
+{
+    LEGIKCONST      *pLeg;
+    long            lFemur;
+    long            lTibia;
+
+    for (LegIndex = 0; LegIndex <= 5; LegIndex++)
+    {
+        pLeg = &LegIKConst[LegIndex];
+        lFemur = (byte)pgm_read_byte(&cFemurLength[LegIndex]);
+        lTibia = (byte)pgm_read_byte(&cTibiaLength[LegIndex]);
+        
+        pLeg->FTDiff4 = (lFemur*lFemur - lTibia*lTibia)*c4DEC;
+        pLeg->FTSum4 = (lFemur*lFemur + lTibia*lTibia)*c4DEC;
+        pLeg->TwoFemur2 = 2*lFemur*c2DEC;
+        pLeg->TwoFemurTibia = 2*lFemur*lTibia;
+        pLeg->ReachOK2 = (lFemur+lTibia-30)*c2DEC;
+        pLeg->Reach2 = (lFemur+lTibia)*c2DEC;
+        pLeg->CoxaAngle1 = (short)pgm_read_word(&cCoxaAngle1[LegIndex]);
+        pLeg->FemurHornOffset1 = CFEMURHORNOFFSET1(LegIndex);
+        pLeg->CoxaLength = (byte)pgm_read_byte(&cCoxaLength[LegIndex]);
+#ifdef c4DOF
+        pLeg->TarsLength = (byte)pgm_read_byte(&cTarsLength[LegIndex]);
+        pLeg->TarsHornOffset1 = CTARSHORNOFFSET1(LegIndex);
+#endif
+    }
+}
+
+
+#ifdef OPT_IKTABLE
+//--------------------------------------------------------------------
+//[LEG IK TABLE] Interpolates the femur and tibia angles from the workspace table
+//IKFeetPosXZ           - Input distance of the feet from the femur axis in the XZ plane
+//IKFeetPosY            - Input position of the feet Y
+//returns               - false if the feet are outside of the table or not in easy reach,
+//                        pIKSol is not set then
+//--------------------------------------------------------------------
+boolean LegIKTable (LEGIKSOLUTION *pIKSol, short IKFeetPosXZ, short IKFeetPosY, LEGIKCONST *pLeg)
+{
+    short           sD = IKFeetPosXZ - cIKTAB_DMIN;
+    short           sY = IKFeetPosY - cIKTAB_YMIN;
+    unsigned long   ulR2;            //Length between Shoulder and Wrist squared
+    const short     *ps;
+    byte            bFracD;
+    byte            bFracY;
+    short           sA0;
+    short           sA1;
+    short           asAngle[2];
+    byte            i;
+
+    if ((sD < 0) || (sD >= ((cIKTAB_ND-1) << cIKTAB_STEPSHIFT)) 
+            || (sY < 0) || (sY >= ((cIKTAB_NY-1) << cIKTAB_STEPSHIFT)))
+        return false;
+ 
+    //Near full reach the tibia angle changes too fast to interpolate, leave that to LegIK.
+    //Is IKSW2 < ReachOK2: IKSW2 is the root of ulR2 (decimals = 4) rounded down
+    ulR2 = (long)IKFeetPosXZ*IKFeetPosXZ + (long)IKFeetPosY*IKFeetPosY;
+    if ((ulR2 < cIKTAB_MINR2) || (ulR2*c4DEC >= (unsigned long)pLeg->ReachOK2*pLeg->ReachOK2))
+        return false;
+    
+    //Bilinear, first along XZ on the grid rows below and above the feet, then along Y
+    ps = GetIKTable[(sY >> cIKTAB_STEPSHIFT)*cIKTAB_ND + (sD >> cIKTAB_STEPSHIFT)];
+    bFracD = sD & ((1 << cIKTAB_STEPSHIFT)-1);
+    bFracY = sY & ((1 << cIKTAB_STEPSHIFT)-1);
+    for (i = 0; i < 2; i++, ps++) {
+        sA0 = (short)pgm_read_word(ps);
+        sA0 += (((short)pgm_read_word(ps+2) - sA0)*bFracD + (1 << (cIKTAB_STEPSHIFT-1))) >> cIKTAB_STEPSHIFT;
+        sA1 = (short)pgm_read_word(ps+2*cIKTAB_ND);
+        sA1 += (((short)pgm_read_word(ps+2*cIKTAB_ND+2) - sA1)*bFracD + (1 << (cIKTAB_STEPSHIFT-1))) >> cIKTAB_STEPSHIFT;
+        asAngle[i] = sA0 + (((sA1 - sA0)*bFracY + (1 << (cIKTAB_STEPSHIFT-1))) >> cIKTAB_STEPSHIFT);
+    }
+    pIKSol->FemurAngle1 = 900 - asAngle[0] + pLeg->FemurHornOffset1;
+    pIKSol->TibiaAngle1 = asAngle[1];
+    pIKSol->bStatus = cIKSolution;
+    return true;
+}
+#endif
+
+
 //--------------------------------------------------------------------
 //[LEG INVERSE KINEMATICS] Calculates the angles of the coxa, femur and tibia for the given position of the feet
 //IKFeetPosX            - Input position of the Feet X
 //IKFeetPosY            - Input position of the Feet Y
 //IKFeetPosZ            - Input Position of the Feet Z
-//IKSolution            - Output true if the solution is possible
-//IKSolutionWarning     - Output true if the solution is NEARLY possible
-//IKSolutionError    - Output true if the solution is NOT possible
-//FemurAngle1           - Output Angle of Femur in degrees
-//TibiaAngle1           - Output Angle of Tibia in degrees
-//CoxaAngle1            - Output Angle of Coxa in degrees
+//returns .bStatus      - cIKSolution, cIKSolutionWarning or cIKSolutionError
+//        .FemurAngle1  - Angle of Femur in degrees
+//        .TibiaAngle1  - Angle of Tibia in degrees
+//        .CoxaAngle1   - Angle of Coxa in degrees
+//        .TarsAngle1   - Angle of Tars in degrees (4DOF legs only)
 //--------------------------------------------------------------------
-void LegIK (short IKFeetPosX, short IKFeetPosY, short IKFeetPosZ, byte LegIKLegNr)
+LEGIKSOLUTION LegIK (short IKFeetPosX, short IKFeetPosY, short IKFeetPosZ, byte LegIKLegNr)
 {
+    LEGIKSOLUTION    IKSol;
+    ATAN2            ATan2;
+    LEGIKCONST       *pLeg = &LegIKConst[LegIKLegNr];
     unsigned long    IKSW2;            //Length between Shoulder and Wrist, decimals = 2
     unsigned long    IKA14;            //Angle of the line S>W with respect to the ground in radians, decimals = 4
     unsigned long    IKA24;            //Angle of the line S>W with respect to the femur in radians, decimals = 4
@@ -1242,15 +2052,23 @@ void LegIK (short IKFeetPosX, short IKFeetPosY, short IKFeetPosZ, byte LegIKLegN
     long            T3;
     
     //Calculate IKCoxaAngle and IKFeetPosXZ
-    GetATan2 (IKFeetPosX, IKFeetPosZ);
-    CoxaAngle1[LegIKLegNr] = (((long)Atan4*180) / 3141) + (short)pgm_read_word(&cCoxaAngle1[LegIKLegNr]);
+    ATan2 = GetATan2 (IKFeetPosX, IKFeetPosZ);
+#ifdef OPT_FIXEDPOINT
+    IKSol.CoxaAngle1 = Rad4ToDeg1(ATan2.atan4) + pLeg->CoxaAngle1;
+#else
+    IKSol.CoxaAngle1 = (((long)ATan2.atan4*180) / 3141) + pLeg->CoxaAngle1;
+#endif
     
     //Length between the Coxa and tars [foot]
-    IKFeetPosXZ = XYhyp2/c2DEC;
+    IKFeetPosXZ = ATan2.hyp2/c2DEC;
+#ifdef OPT_IKTABLE
+    if (LegIKTable(&IKSol, IKFeetPosXZ-pLeg->CoxaLength, IKFeetPosY, pLeg))
+        return IKSol;
+#endif
 #ifdef c4DOF
     // Some legs may have the 4th DOF and some may not, so handle this here...
     //Calc the TarsToGroundAngle1:
-    if ((byte)pgm_read_byte(&cTarsLength[LegIKLegNr])) {    // We allow mix of 3 and 4 DOF legs...
+    if (pLeg->TarsLength) {    // We allow mix of 3 and 4 DOF legs...
         TarsToGroundAngle1 = -cTarsConst + cTarsMulti*IKFeetPosY + ((long)(IKFeetPosXZ*cTarsFactorA))/c1DEC - ((long)(IKFeetPosXZ*IKFeetPosY)/(cTarsFactorB));
         if (IKFeetPosY < 0)     //Always compensate TarsToGroundAngle1 when IKFeetPosY it goes below zero
             TarsToGroundAngle1 = TarsToGroundAngle1 - ((long)(IKFeetPosY*cTarsFactorC)/c1DEC);     //TGA base, overall rule
@@ -1272,9 +2090,9 @@ void LegIK (short IKFeetPosX, short IKFeetPosY, short IKFeetPosZ, byte LegIKLegN
             TarsToGroundAngle1 = TGA_B_H3;
 		
         //Calc Tars Offsets:
-        GetSinCos(TarsToGroundAngle1);
-        TarsOffsetXZ = ((long)sin4*(byte)pgm_read_byte(&cTarsLength[LegIKLegNr]))/c4DEC;
-        TarsOffsetY = ((long)cos4*(byte)pgm_read_byte(&cTarsLength[LegIKLegNr]))/c4DEC;
+        SINCOS SinCos = GetSinCos(TarsToGroundAngle1);
+        TarsOffsetXZ = ((long)SinCos.sin4*pLeg->TarsLength)/cSINCOS_ONE;
+        TarsOffsetY = ((long)SinCos.cos4*pLeg->TarsLength)/cSINCOS_ONE;
     } else {
         TarsOffsetXZ = 0;
         TarsOffsetY = 0;
@@ -1283,54 +2101,154 @@ void LegIK (short IKFeetPosX, short IKFeetPosY, short IKFeetPosZ, byte LegIKLegN
     
     //Using GetAtan2 for solving IKA1 and IKSW
     //IKA14 - Angle between SW line and the ground in radians
-    IKA14 = GetATan2 (IKFeetPosY-TarsOffsetY, IKFeetPosXZ-(byte)pgm_read_byte(&cCoxaLength[LegIKLegNr])-TarsOffsetXZ);
+    ATan2 = GetATan2 (IKFeetPosY-TarsOffsetY, IKFeetPosXZ-pLeg->CoxaLength-TarsOffsetXZ);
+    IKA14 = ATan2.atan4;
     
     //IKSW2 - Length between femur axis and tars
-    IKSW2 = XYhyp2;
+    IKSW2 = ATan2.hyp2;
     
     //IKA2 - Angle of the line S>W with respect to the femur in radians
-    Temp1 = ((((long)(byte)pgm_read_byte(&cFemurLength[LegIKLegNr])*(byte)pgm_read_byte(&cFemurLength[LegIKLegNr])) - ((long)(byte)pgm_read_byte(&cTibiaLength[LegIKLegNr])*(byte)pgm_read_byte(&cTibiaLength[LegIKLegNr])))*c4DEC + ((long)IKSW2*IKSW2));
-    Temp2 = (long)(2*(byte)pgm_read_byte(&cFemurLength[LegIKLegNr]))*c2DEC * (unsigned long)IKSW2;
+    Temp1 = pLeg->FTDiff4 + ((long)IKSW2*IKSW2);
+    Temp2 = (long)pLeg->TwoFemur2 * (unsigned long)IKSW2;
     T3 = Temp1 / (Temp2/c4DEC);
     IKA24 = GetArcCos (T3 );
     //IKFemurAngle
-    FemurAngle1[LegIKLegNr] = -(long)(IKA14 + IKA24) * 180 / 3141 + 900 + CFEMURHORNOFFSET1(LegIKLegNr);
+#ifdef OPT_FIXEDPOINT
+    IKSol.FemurAngle1 = -Rad4ToDeg1(IKA14 + IKA24) + 900 + pLeg->FemurHornOffset1;
+#else
+    IKSol.FemurAngle1 = -(long)(IKA14 + IKA24) * 180 / 3141 + 900 + pLeg->FemurHornOffset1;
+#endif
 
     //IKTibiaAngle
-    Temp1 = ((((long)(byte)pgm_read_byte(&cFemurLength[LegIKLegNr])*(byte)pgm_read_byte(&cFemurLength[LegIKLegNr])) + ((long)(byte)pgm_read_byte(&cTibiaLength[LegIKLegNr])*(byte)pgm_read_byte(&cTibiaLength[LegIKLegNr])))*c4DEC - ((long)IKSW2*IKSW2));
-    Temp2 = (2*(byte)pgm_read_byte(&cFemurLength[LegIKLegNr])*(byte)pgm_read_byte(&cTibiaLength[LegIKLegNr]));
-    GetArcCos (Temp1 / Temp2);
-    TibiaAngle1[LegIKLegNr] = -(900-(long)AngleRad4*180/3141);
+    Temp1 = pLeg->FTSum4 - ((long)IKSW2*IKSW2);
+    Temp2 = pLeg->TwoFemurTibia;
+#ifdef OPT_FIXEDPOINT
+    IKSol.TibiaAngle1 = -(900-Rad4ToDeg1(GetArcCos (Temp1 / Temp2)));
+#else
+    IKSol.TibiaAngle1 = -(900-(long)GetArcCos (Temp1 / Temp2)*180/3141);
+#endif
 
 #ifdef c4DOF
     //Tars angle
-    if ((byte)pgm_read_byte(&cTarsLength[LegIKLegNr])) {    // We allow mix of 3 and 4 DOF legs...
-        TarsAngle1[LegIKLegNr] = (TarsToGroundAngle1 + FemurAngle1[LegIKLegNr] - TibiaAngle1[LegIKLegNr]) 
-             + CTARSHORNOFFSET1(LegIKLegNr);
+    if (pLeg->TarsLength) {    // We allow mix of 3 and 4 DOF legs...
+        IKSol.TarsAngle1 = (TarsToGroundAngle1 + IKSol.FemurAngle1 - IKSol.TibiaAngle1) 
+             + pLeg->TarsHornOffset1;
     }
 #endif
 
     //Set the Solution quality    
-    if(IKSW2 < ((byte)pgm_read_byte(&cFemurLength[LegIKLegNr])+(byte)pgm_read_byte(&cTibiaLength[LegIKLegNr])-30)*c2DEC)
-        IKSolution = 1;
+    if(IKSW2 < pLeg->ReachOK2)
+        IKSol.bStatus = cIKSolution;
     else
     {
-        if(IKSW2 < ((byte)pgm_read_byte(&cFemurLength[LegIKLegNr])+(byte)pgm_read_byte(&cTibiaLength[LegIKLegNr]))*c2DEC) 
-            IKSolutionWarning = 1;
+        if(IKSW2 < pLeg->Reach2) 
+            IKSol.bStatus = cIKSolutionWarning;
         else
-            IKSolutionError = 1    ;
+            IKSol.bStatus = cIKSolutionError;
+    }
+    return IKSol;
+}
+
+
+//--------------------------------------------------------------------
+//[SetLegIK] Stores the IK solution of a leg as the new angles of its servos
+//         and adds its status to the status of this cycle
+//--------------------------------------------------------------------
+void SetLegIK (byte LegIKLegNr, LEGIKSOLUTION IKSol)
+{
+    CoxaAngle1[LegIKLegNr] = IKSol.CoxaAngle1;
+    FemurAngle1[LegIKLegNr] = IKSol.FemurAngle1;
+    TibiaAngle1[LegIKLegNr] = IKSol.TibiaAngle1;
+#ifdef c4DOF
+    if (LegIKConst[LegIKLegNr].TarsLength)     // We allow mix of 3 and 4 DOF legs...
+        TarsAngle1[LegIKLegNr] = IKSol.TarsAngle1;
+#endif
+#ifdef OPT_IK_CACHE
+    g_aIKCacheLegs[LegIKLegNr].bStatus = IKSol.bStatus;
+#endif
+    AddIKStatus(IKSol.bStatus);
+}
+
+//--------------------------------------------------------------------
+//[AddIKStatus] Adds the status of a leg's IK solution to the status of this cycle
+//--------------------------------------------------------------------
+void AddIKStatus (byte bStatus)
+{
+    if (bStatus == cIKSolution)
+        IKSolution = 1;
+    else if (bStatus == cIKSolutionWarning)
+        IKSolutionWarning = 1;
+    else
+        IKSolutionError = 1;
+}
+
+#ifdef OPT_IK_CACHE
+//--------------------------------------------------------------------
+//[IK CACHE BODY] Forgets the angles of all legs when the body rotation or the
+//center of rotation changed.  Call after BodyRotUpdate.
+//--------------------------------------------------------------------
+void IKCacheBody (void)
+{
+    IKCACHEBODY     *pBody = &g_IKCacheBody;
+
+    if ((BodyRot.RotX1 != pBody->RotX1) || (BodyRot.RotZ1 != pBody->RotZ1) || (BodyRot.RotY1 != pBody->RotY1)
+            || (g_InControlState.BodyPos.x != pBody->BodyPosX) || (BodyRotOffsetX != pBody->RotOffsetX)
+            || (BodyRotOffsetY != pBody->RotOffsetY) || (BodyRotOffsetZ != pBody->RotOffsetZ)) {
+        pBody->RotX1 = BodyRot.RotX1;
+        pBody->RotZ1 = BodyRot.RotZ1;
+        pBody->RotY1 = BodyRot.RotY1;
+        pBody->BodyPosX = g_InControlState.BodyPos.x;
+        pBody->RotOffsetX = BodyRotOffsetX;
+        pBody->RotOffsetY = BodyRotOffsetY;
+        pBody->RotOffsetZ = BodyRotOffsetZ;
+        for (byte LegNr = 0; LegNr <= 5; LegNr++)
+            g_aIKCacheLegs[LegNr].fValid = false;
     }
 }
 
+//--------------------------------------------------------------------
+//[IK CACHE HIT] True when the leg still has the angles for this BodyFK input:
+//its status is added and BodyFK, LegIK and CheckAngles are left out for it.
+//The LegIK input follows from the BodyFK input and output (and BodyPos.x),
+//so this is all it depends on.
+//--------------------------------------------------------------------
+boolean FIKCacheHit (byte LegIKLegNr, short PosX, short PosZ, short PosY, short RotationY)
+{
+    IKCACHELEG      *pLeg = &g_aIKCacheLegs[LegIKLegNr];
+
+    g_cIKCacheLegs++;
+    if (pLeg->fValid && (pLeg->PosX == PosX) && (pLeg->PosZ == PosZ) && (pLeg->PosY == PosY)
+            && (pLeg->RotY == RotationY)) {
+        pLeg->fHit = true;
+        g_cIKCacheHits++;
+        AddIKStatus(pLeg->bStatus);
+        return true;
+    }
+    pLeg->PosX = PosX;
+    pLeg->PosZ = PosZ;
+    pLeg->PosY = PosY;
+    pLeg->RotY = RotationY;
+    pLeg->fValid = true;
+    pLeg->fHit = false;
+    return false;
+}
+#endif
+
 
 //--------------------------------------------------------------------
 //[CHECK ANGLES] Checks the mechanical limits of the servos
 //--------------------------------------------------------------------
 void CheckAngles(void)
 {
-
+#ifdef OPT_LEGTEMPLATES
+    LEGS_DO(Limit);
+#else
     for (LegIndex = 0; LegIndex <=5; LegIndex++)
     {
+#ifdef OPT_IK_CACHE
+        if (g_aIKCacheLegs[LegIndex].fHit)
+            continue;                       //Checked when they were worked out
+#endif
         CoxaAngle1[LegIndex]  = min(max(CoxaAngle1[LegIndex], (short)pgm_read_word(&cCoxaMin1[LegIndex])), 
                     (short)pgm_read_word(&cCoxaMax1[LegIndex]));
         FemurAngle1[LegIndex] = min(max(FemurAngle1[LegIndex], (short)pgm_read_word(&cFemurMin1[LegIndex])),
@@ -1344,8 +2262,88 @@ void CheckAngles(void)
         }
 #endif
     }
+#endif
+}
+
+#ifdef OPT_LEGTEMPLATES
+//--------------------------------------------------------------------
+//[LEG PIPELINE] The leg by leg steps of loop() for leg LEG.  The same math as
+//the loops over LegIndex, with the side, offsets, limits and DOF of the leg
+//from Hex_Robot.h: only the branch for this leg is left in each copy.
+//--------------------------------------------------------------------
+template <byte LEG> void LEGPIPE<LEG>::Balance(void)
+{
+    if (LEGDESC<LEG>::fLeft)
+        BalCalcOneLeg(LegPosX[LEG]+GaitPosX[LEG], LegPosZ[LEG]+GaitPosZ[LEG],
+                (LegPosY[LEG]-(short)LEGDESC<LEG>::InitPosY)+GaitPosY[LEG], LEG);
+    else
+        BalCalcOneLeg(-LegPosX[LEG]+GaitPosX[LEG], LegPosZ[LEG]+GaitPosZ[LEG],
+                (LegPosY[LEG]-(short)LEGDESC<LEG>::InitPosY)+GaitPosY[LEG], LEG);
+}
+
+template <byte LEG> void LEGPIPE<LEG>::FKIK(void)
+{
+    short           PosX;           //BodyFK input, as in BodyFK
+    short           PosZ;
+    short           PosY;
+    COORD3D         BodyFKPos;
+
+    if (LEGDESC<LEG>::fLeft)
+        PosX = LegPosX[LEG]-g_InControlState.BodyPos.x+GaitPosX[LEG] - TotalTransX;
+    else
+        PosX = -LegPosX[LEG]+g_InControlState.BodyPos.x+GaitPosX[LEG] - TotalTransX;
+    PosZ = LegPosZ[LEG]+g_InControlState.BodyPos.z+GaitPosZ[LEG] - TotalTransZ;
+    PosY = LegPosY[LEG]+g_InControlState.BodyPos.y+GaitPosY[LEG] - TotalTransY;
+#ifdef OPT_IK_CACHE
+    if (FIKCacheHit(LEG, PosX, PosZ, PosY, GaitRotY[LEG]))
+        return;
+#endif
+    BodyFKPos = BodyFKCPR(&BodyRot, (short)LEGDESC<LEG>::OffsetX + PosX + BodyRotOffsetX,
+            (short)LEGDESC<LEG>::OffsetZ + PosZ + BodyRotOffsetZ, PosY + BodyRotOffsetY, GaitRotY[LEG]);
+
+    if (LEGDESC<LEG>::fLeft)
+        SetLegIK(LEG, LegIK(LegPosX[LEG]+g_InControlState.BodyPos.x-BodyFKPos.x+GaitPosX[LEG] - TotalTransX,
+                LegPosY[LEG]+g_InControlState.BodyPos.y-BodyFKPos.y+GaitPosY[LEG] - TotalTransY,
+                LegPosZ[LEG]+g_InControlState.BodyPos.z-BodyFKPos.z+GaitPosZ[LEG] - TotalTransZ, LEG));
+    else
+        SetLegIK(LEG, LegIK(LegPosX[LEG]-g_InControlState.BodyPos.x+BodyFKPos.x-(GaitPosX[LEG] - TotalTransX),
+                LegPosY[LEG]+g_InControlState.BodyPos.y-BodyFKPos.y+GaitPosY[LEG] - TotalTransY,
+                LegPosZ[LEG]+g_InControlState.BodyPos.z-BodyFKPos.z+GaitPosZ[LEG] - TotalTransZ, LEG));
 }
 
+template <byte LEG> void LEGPIPE<LEG>::Limit(void)
+{
+#ifdef OPT_IK_CACHE
+    if (g_aIKCacheLegs[LEG].fHit)
+        return;
+#endif
+    CoxaAngle1[LEG]  = min(max(CoxaAngle1[LEG], (short)LEGDESC<LEG>::CoxaMin1), (short)LEGDESC<LEG>::CoxaMax1);
+    FemurAngle1[LEG] = min(max(FemurAngle1[LEG], (short)LEGDESC<LEG>::FemurMin1), (short)LEGDESC<LEG>::FemurMax1);
+    TibiaAngle1[LEG] = min(max(TibiaAngle1[LEG], (short)LEGDESC<LEG>::TibiaMin1), (short)LEGDESC<LEG>::TibiaMax1);
+#ifdef c4DOF
+    if (LEGDESC<LEG>::TarsLength)
+        TarsAngle1[LEG] = min(max(TarsAngle1[LEG], (short)LEGDESC<LEG>::TarsMin1), (short)LEGDESC<LEG>::TarsMax1);
+#endif
+}
+
+template <byte LEG> void LEGPIPE<LEG>::Output(void)
+{
+#ifdef c4DOF
+    g_ServoDriver.OutputServoInfoForLeg<LEG>(CoxaAngle1[LEG], FemurAngle1[LEG], TibiaAngle1[LEG], TarsAngle1[LEG]);
+#else
+    g_ServoDriver.OutputServoInfoForLeg<LEG>(CoxaAngle1[LEG], FemurAngle1[LEG], TibiaAngle1[LEG]);
+#endif
+}
+
+//--------------------------------------------------------------------
+//[LEGS IK] BodyFK and LegIK of all legs, right ones first
+//--------------------------------------------------------------------
+void LegsIK(void)
+{
+    LEGS_DO(FKIK);
+}
+#endif
+
 //--------------------------------------------------------------------
 // Why are we faulting?
 //--------------------------------------------------------------------
@@ -1394,6 +2392,180 @@ void SoundNoTimer(uint8_t _pin, unsigned long duration,  unsigned int frequency)
 
 }
 
+#ifdef OPT_SOUNDQUEUE
+//==============================================================================
+//    Sound queue - MSound queues the notes and returns at once.  They play in
+//            the background: on AVR a Timer2 interrupt toggles the pin, on
+//            other boards SoundService does it when it is called.  Notes that
+//            do not fit in the queue are dropped.  MSound works out the timer
+//            settings of a note when it queues it, so starting the next note
+//            in the interrupt only loads them.
+//==============================================================================
+typedef struct _SoundNote {
+#ifdef __AVR__
+    volatile uint8_t *pbPort;       // output register and bit of the pin, no bit for a rest
+    byte        bMask;
+    byte        bTCCR2B;            // Timer2 prescaler and compare value for a half cycle
+    byte        bOCR2A;
+    unsigned long cToggles;         // half cycles
+#else
+    volatile uint32_t *pbPort;
+    uint16_t    bMask;
+    unsigned long ulLen;            // us
+    unsigned long ulHalfCycle;      // us
+#endif
+} SOUNDNOTE;
+
+static SOUNDNOTE        s_aSoundQueue[cSOUND_QUEUE];
+static volatile byte    s_iSoundHead;       // next note to play
+static volatile byte    s_iSoundTail;       // where MSound puts the next note
+static volatile boolean s_fSoundPlaying;
+byte                    g_cSoundDropped;    // notes that did not fit, stops at 255
+
+#ifdef __AVR__
+static volatile uint8_t *s_pbSoundPort;     // output register and bit of the note playing
+static byte             s_bSoundMask;
+static unsigned long    s_cSoundToggles;    // half cycles left
+static const word s_awTimer2Prescale[] PROGMEM = {1, 8, 32, 64, 128, 256, 1024};
+#else
+static volatile uint32_t *s_pbSoundPort;
+static uint16_t         s_bSoundMask;
+static unsigned long    s_ulSoundStart;     // micros() the note started
+static unsigned long    s_ulSoundLen;       // us
+static unsigned long    s_ulSoundHalfCycle; // us
+static unsigned long    s_cSoundToggles;    // half cycles done
+#endif
+
+//Works out the pin register, the timer settings and the length of a note
+static void SoundNoteInit(SOUNDNOTE *pNote, uint8_t bPin, word wDur, word wFreq)
+{
+    pNote->pbPort = portOutputRegister(digitalPinToPort(bPin));
+    pNote->bMask = wFreq? digitalPinToBitMask(bPin) : 0;
+    if (!wFreq)
+        wFreq = 1000;                                   //A rest counts silent half cycles
+#ifdef __AVR__
+    unsigned long   ulTicks = F_CPU / 2 / wFreq;        //Timer ticks per half cycle without prescaler
+    byte            iPrescale;
+    word            wPrescale;
+    
+    pNote->cToggles = max(2UL * wFreq * wDur / 1000, 1UL);
+    for (iPrescale = 0; ; iPrescale++) {
+        wPrescale = pgm_read_word(&s_awTimer2Prescale[iPrescale]);
+        if ((ulTicks / wPrescale <= 256) || (iPrescale == 6))
+            break;
+    }
+    ulTicks /= wPrescale;
+    pNote->bTCCR2B = iPrescale + 1;
+    pNote->bOCR2A = (ulTicks > 256)? 255 : (ulTicks? ulTicks - 1 : 0);
+#else
+    pNote->ulLen = (unsigned long)wDur * 1000;
+    pNote->ulHalfCycle = 500000UL / wFreq;
+#endif
+}
+
+//Starts the note at the head of the queue, or stops when it is empty.  With interrupts off.
+static void SoundNextNote(void)
+{
+    SOUNDNOTE   *pNote;
+    
+    if (s_iSoundHead == s_iSoundTail) {
+#ifdef __AVR__
+        TIMSK2 &= ~_BV(OCIE2A);
+#endif
+        s_fSoundPlaying = false;
+        return;
+    }
+    pNote = &s_aSoundQueue[s_iSoundHead];
+    s_iSoundHead = (s_iSoundHead + 1) % cSOUND_QUEUE;
+
+    s_pbSoundPort = pNote->pbPort;
+    s_bSoundMask = pNote->bMask;
+#ifdef __AVR__
+    s_cSoundToggles = pNote->cToggles;
+    TCCR2A = _BV(WGM21);                                //CTC
+    TCCR2B = pNote->bTCCR2B;
+    OCR2A = pNote->bOCR2A;
+    TCNT2 = 0;
+    TIFR2 = _BV(OCF2A);
+    TIMSK2 |= _BV(OCIE2A);
+#else
+    s_ulSoundStart = micros();
+    s_ulSoundLen = pNote->ulLen;
+    s_ulSoundHalfCycle = pNote->ulHalfCycle;
+    s_cSoundToggles = 0;
+#endif
+    s_fSoundPlaying = true;
+}
+
+#ifdef __AVR__
+ISR(TIMER2_COMPA_vect)
+{
+    *s_pbSoundPort ^= s_bSoundMask;
+    if (!--s_cSoundToggles) {
+        *s_pbSoundPort &= ~s_bSoundMask;                //keep pin low after the note
+        SoundNextNote();
+    }
+}
+
+void SoundService(void)
+{
+}
+#else
+//Toggles the pin when a half cycle went by and moves on to the next note when it is done
+void SoundService(void)
+{
+    unsigned long   ulTime;
+    
+    while (s_fSoundPlaying) {
+        ulTime = micros() - s_ulSoundStart;
+        if (ulTime < s_ulSoundLen) {
+            if (ulTime / s_ulSoundHalfCycle != s_cSoundToggles) {
+                s_cSoundToggles = ulTime / s_ulSoundHalfCycle;
+                *s_pbSoundPort ^= s_bSoundMask;
+            }
+            return;
+        }
+        *s_pbSoundPort &= ~s_bSoundMask;
+        SoundNextNote();
+    }
+}
+#endif
+
+void MSound(uint8_t _pin, byte cNotes, ...)
+{
+    va_list ap;
+    byte    iTail;
+    word    wDur;
+    va_start(ap, cNotes);
+
+    pinMode(_pin, OUTPUT);
+    while (cNotes > 0) {
+        iTail = (s_iSoundTail + 1) % cSOUND_QUEUE;
+        if (iTail == s_iSoundHead) {
+            if (g_cSoundDropped != 0xff)
+                g_cSoundDropped++;
+            va_arg(ap, unsigned int);
+            va_arg(ap, unsigned int);
+        } else {
+            wDur = va_arg(ap, unsigned int);
+            SoundNoteInit(&s_aSoundQueue[s_iSoundTail], _pin, wDur, va_arg(ap, unsigned int));
+            s_iSoundTail = iTail;
+        }
+        cNotes--;
+    }
+    va_end(ap);
+
+#ifdef __AVR__
+    uint8_t oldSREG = SREG;
+    cli();
+#endif
+    if (!s_fSoundPlaying)
+        SoundNextNote();
+#ifdef __AVR__
+    SREG = oldSREG;
+#endif
+}
+#else
 void MSound(uint8_t _pin, byte cNotes, ...)
 {
     va_list ap;
@@ -1409,6 +2581,7 @@ void MSound(uint8_t _pin, byte cNotes, ...)
     }
     va_end(ap);
 }
+#endif
 
 #ifdef OPT_TERMINAL_MONITOR
 //==============================================================================
@@ -1430,16 +2603,22 @@ boolean TerminalMonitor(void)
 #endif        
 #ifdef OPT_SSC_FORWARDER
         DBGSerial.println("S - SSC Forwarder");
+#endif        
+#ifdef OPT_SCHEDULER
+        DBGSerial.println("T - Cycle timing");
+#endif        
+#ifdef OPT_PROFILE
+        DBGSerial.println("P - Stage times");
 #endif        
         g_fShowDebugPrompt = false;
     }
        
     // First check to see if there is any characters to process.
-    if (ich = DBGSerial.available()) {
+    if (DBGSerial.available()) {
         ich = 0;
         // For now assume we receive a packet of data from serial monitor, as the user has
         // to click the send button...
-        for (ich=0; ich < sizeof(szCmdLine); ich++) {
+        for (ich=0; ich < (int)sizeof(szCmdLine); ich++) {
             ch = DBGSerial.read();        // get the next character
             if ((ch == -1) || ((ch >= 10) && (ch <= 15)))
                 break;
@@ -1465,6 +2644,14 @@ boolean TerminalMonitor(void)
 #ifdef OPT_SSC_FORWARDER
         } else if ((ich == 1) && ((szCmdLine[0] == 's') || (szCmdLine[0] == 'S'))) {
             g_ServoDriver.SSCForwarder();
+#endif
+#ifdef OPT_SCHEDULER
+        } else if ((ich == 1) && ((szCmdLine[0] == 't') || (szCmdLine[0] == 'T'))) {
+            PrintSchedStats();
+#endif
+#ifdef OPT_PROFILE
+        } else if ((ich == 1) && ((szCmdLine[0] == 'p') || (szCmdLine[0] == 'P'))) {
+            PrintProfile();
 #endif
         }
         
@@ -1472,6 +2659,82 @@ boolean TerminalMonitor(void)
     }
     return false;
 }
+
+#ifdef OPT_SCHEDULER
+//==============================================================================
+// PrintSchedStats - Cycles, late cycles and how late they started since the
+//    last time, then starts counting again.
+//==============================================================================
+void PrintSchedStats(void)
+{
+    byte    iBucket;
+    
+    DBGSerial.print("Cycles: ");
+    DBGSerial.print(g_SchedStats.cCycles, DEC);
+    DBGSerial.print(" Missed: ");
+    DBGSerial.print(g_SchedStats.cMissed, DEC);
+    DBGSerial.print(" Max late(us): ");
+    DBGSerial.println(g_SchedStats.ulMaxLate, DEC);
+    for (iBucket = 0; iBucket < cSCHED_LATEBUCKETS; iBucket++) {
+        DBGSerial.print((iBucket < cSCHED_LATEBUCKETS-1)? " <" : ">=");
+        DBGSerial.print((64UL << ((iBucket < cSCHED_LATEBUCKETS-1)? iBucket : iBucket-1)), DEC);
+        DBGSerial.print("us: ");
+        DBGSerial.println(g_SchedStats.awLate[iBucket], DEC);
+    }
+    memset(&g_SchedStats, 0, sizeof(g_SchedStats));
+#ifdef OPT_IDLE
+    DBGSerial.print("Idle cycles: ");
+    DBGSerial.print(g_cIdleCycles, DEC);
+    DBGSerial.print(" Wakes: ");
+    DBGSerial.println(g_cIdleWakes, DEC);
+    g_cIdleCycles = 0;
+    g_cIdleWakes = 0;
+#endif
+}
+#endif
+
+#ifdef OPT_PROFILE
+//==============================================================================
+// PrintProfile - Calls, min, avg and max time in us of each stage since the
+//    last time, then starts again.
+//==============================================================================
+static const char s_aszProfStages[NUM_PROFSTAGES][10] PROGMEM = {
+    "Voltage", "Input", "GPPlayer", "SingleLeg", "GaitSeq", "Balance", "FK/IK", "Angles", "Servos", "Commit",
+    "MoveWait", "MoveSaved"};
+
+void PrintProfile(void)
+{
+    byte        iStage;
+    byte        ich;
+    char        ch;
+    PROFSTAGE   *pStage;
+    
+    DBGSerial.println("Stage     Calls Min Avg Max (us)");
+    for (iStage = 0; iStage < NUM_PROFSTAGES; iStage++) {
+        pStage = &g_aProfStages[iStage];
+        for (ich = 0; ich < sizeof(s_aszProfStages[0]); ich++) {
+            ch = pgm_read_byte(&s_aszProfStages[iStage][ich]);
+            DBGSerial.write(ch? ch : ' ');
+        }
+        DBGSerial.print(pStage->cCalls, DEC);
+        DBGSerial.print(" ");
+        DBGSerial.print(pStage->wMin, DEC);
+        DBGSerial.print(" ");
+        DBGSerial.print(pStage->cCalls? (pStage->ulSum / pStage->cCalls) : 0, DEC);
+        DBGSerial.print(" ");
+        DBGSerial.println(pStage->wMax, DEC);
+    }
+#ifdef OPT_IK_CACHE
+    DBGSerial.print("IK cache: ");
+    DBGSerial.print(g_cIKCacheHits, DEC);
+    DBGSerial.print(" of ");
+    DBGSerial.print(g_cIKCacheLegs, DEC);
+    DBGSerial.println(" legs kept their angles");
+#endif
+    ProfReset();
+}
+#endif
+
 #endif
 
 //--------------------------------------------------------------------
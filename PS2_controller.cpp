@@ -124,10 +124,8 @@ void InputController::Init(void)
 {
   //DBGSerial.begin(57600)
   
-    int error;
-
-    //error = ps2x.config_gamepad(57, 55, 56, 54);  // Setup gamepad (clock, command, attention, data) pins
-    error = ps2x.config_gamepad(PS2_CLK, PS2_CMD, PS2_SEL, PS2_DAT);  // Setup gamepad (clock, command, attention, data) pins
+    //ps2x.config_gamepad(57, 55, 56, 54);  // Setup gamepad (clock, command, attention, data) pins
+    ps2x.config_gamepad(PS2_CLK, PS2_CMD, PS2_SEL, PS2_DAT);  // Setup gamepad (clock, command, attention, data) pins
 
     g_BodyYOffset = 65;  // 0 - Devon wanted...
     g_BodyYShift = 0;
@@ -432,9 +430,21 @@ void InputController::ControlInput(void)
                         }
                     }
                 }
-                //Start Sequence
-                if (ps2x.ButtonPressed(PSB_R2))// R2 Button Test
-                    g_ServoDriver.GPStartSeq(GPSeq);
+                //Start Sequence, or stop the one playing
+                if (ps2x.ButtonPressed(PSB_R2)) {// R2 Button Test
+                    if (!g_ServoDriver.FIsGPSeqActive()) {
+                        if (g_ServoDriver.FIsGPSeqDefined(GPSeq))
+                            g_ServoDriver.GPStartSeq(GPSeq);
+                        else
+                            MSound (SOUND_PIN, 2, 50, 2000, 50, 2000);  //Sequence not in the SSC-32
+                    } else {
+                        MSound (SOUND_PIN, 1, 50, 1500);  //sound SOUND_PIN, [50\3000]
+                        g_ServoDriver.GPCancel();
+                    }
+                }
+                
+                //Speed of the sequence: Right Stick Up/Down, 10 - 190% in steps of 10
+                g_ServoDriver.GPSetSpeed(100 + ((128 - ps2x.Analog(PSS_RY)) / 14) * 10);
             }
 #endif // OPT_GPPLAYER
 
@@ -474,6 +484,9 @@ void PS2TurnRobotOff(void)
     g_BodyYShift = 0;
     g_InControlState.SelectedLeg = 255;
     g_InControlState.fHexOn = 0;
+#ifdef OPT_GPPLAYER
+    g_ServoDriver.GPCancel();
+#endif
 }
 
 
@@ -16,15 +16,79 @@
 #include <Wprogram.h> // Arduino 0022
 #endif
 
+#ifdef c4DOF
+#define NUMSERVOSPERLEG 4
+#else
+#define NUMSERVOSPERLEG 3
+#endif
+#define NUMSERVOS           (6*NUMSERVOSPERLEG + 5 + 2)     // legs + mandibles + tail
+
+// Size of the buffer one SSC-32 group move is formatted into.
+#ifdef cSSC_BINARYMODE
+#define SSC_SERVOFRAMESIZE  (NUMSERVOS*3 + 3)               // <0x80+pin><hi><lo> ... <0xA1><hi><lo>
+#else
+#define SSC_SERVOFRAMESIZE  (NUMSERVOS*9 + 8)               // #<pin>P<pulse> ... T<time><cr><lf>
+#endif
+#define SSC_NUMCHANNELS     32
+#define SSC_FREEFRAMESIZE   (SSC_NUMCHANNELS*5 + 5)         // #<pin>P0 for all 32 channels + T200<cr>
+#define SSC_FRAMESIZE       ((SSC_SERVOFRAMESIZE > SSC_FREEFRAMESIZE)? SSC_SERVOFRAMESIZE : SSC_FREEFRAMESIZE)
+
+// With background transmit one frame is built while the other one is on the wire.
+#ifdef OPT_SSC_ASYNCTX
+#define SSC_NUMFRAMEBUFS    2
+#else
+#define SSC_NUMFRAMEBUFS    1
+#endif
+
+// One query to the SSC-32 can be out at a time.  SSCQueryStart sends it off and
+// SSCQueryPoll collects the reply out of the serial driver's receive ring as the
+// bytes come in, so nobody has to sit and wait for them.
+#define SSCQ_IDLE           0
+#define SSCQ_PENDING        1       // reply not complete yet
+#define SSCQ_DONE           2       // got all the bytes asked for, or the end of line
+#define SSCQ_TIMEOUT        3       // nothing came for the timeout, _cbQReply has what did
+#define SSC_NOEOL           0xffff  // binary reply, only the count ends it
+#define SSC_QUERYSIZE       24
+
+#define SSCQFOR_NONE        0       // who sent the query that is out
+#define SSCQFOR_VER         1
+#define SSCQFOR_GPSEQ       2
+#define SSCQFOR_GPSTAT      3
+#define SSCQFOR_REG         4
+#define SSCQFOR_MOVE        5
+
+#ifdef OPT_SSC_MOVESYNC
+#define MOVESYNC_DONE       0
+#define MOVESYNC_MOVING     1       // ask with "Q" when the frame is out
+#define MOVESYNC_QUERY      2       // "Q" is out
+#define MOVESYNC_NOQ        3       // no reply to "Q", only the lead time ends the move
+#endif
+
+#ifdef OPT_GPPLAYER
+#define GPSTATE_IDLE        0
+#define GPSTATE_START       1       // start the sequence on the next GPPlayer
+#define GPSTATE_WAIT        2       // playing, waiting to ask for the status
+#define GPSTATE_QUERY       3       // playing, waiting for the status reply
+#endif
+
 class ServoDriver {
   public:
     void Init(void);
 
 #ifdef OPT_GPPLAYER    
+    // GPPlayer is called once per loop and plays the sequence in steps, the loop
+    // keeps going.  Progress is from the last status query of the SSC-32.  It also
+    // finishes the version check of Init and looks up which sequences are defined.
     inline boolean  FIsGPEnabled(void) {return _fGPEnabled;};
     boolean         FIsGPSeqDefined(uint8_t iSeq);
-    inline boolean  FIsGPSeqActive(void) {return _fGPActive;};
+    inline boolean  FIsGPSeqActive(void) {return _bGPState != GPSTATE_IDLE;};
     void            GPStartSeq(uint8_t iSeq);
+    void            GPCancel(void);
+    void            GPSetSpeed(short sSpeed);   // % of the recorded speed, -200..200
+    inline short    GPSpeed(void) {return _sGPSpeed;};
+    inline byte     GPFromStep(void) {return _abGPStat[1];};
+    inline byte     GPToStep(void) {return _abGPStat[2];};
+    inline byte     GPStepTime(void) {return _abGPStat[3];};   // left of the step, as the SSC-32 reports it
     void            GPPlayer(void);
 #endif
     void BeginServoUpdate(void);    // Start the update 
@@ -34,13 +98,49 @@ class ServoDriver {
 #else
     void OutputServoInfoForLeg(byte LegIndex, short sCoxaAngle1, short sFemurAngle1, short sTibiaAngle1);
 #endif 
+#ifdef OPT_LEGTEMPLATES
+    // The same for leg LEG, with its side, pins and DOF from Hex_Robot.h
+#ifdef c4DOF
+    template <byte LEG> void OutputServoInfoForLeg(short sCoxaAngle1, short sFemurAngle1, short sTibiaAngle1, short sTarsAngle1);
+#else
+    template <byte LEG> void OutputServoInfoForLeg(short sCoxaAngle1, short sFemurAngle1, short sTibiaAngle1);
+#endif
+#endif
 
     void OutputServoInfoForMandibles(short xRot, short yRot, short zRot, short lRot, short rRot);
     void OutputServoInfoForTails(short xRot, short yRot);
 
     void CommitServoDriver(word wMoveTime);
     void FreeServos(void);
+    void InvalidateShadow(void);    // The next frame sends all servos
+
+    // Background transmit of the committed frame.  When OPT_SSC_ASYNCTX is not
+    // defined the frame is already sent by the time Commit returns and these
+    // do nothing special.
+    void TxService(void);           // Keep the frame going, call every few ms
+    void TxFlush(void);             // Wait until all of the frame is handed to the UART
+    void TxDelay(word wMS);         // delay() that keeps the frame going
+
+#ifdef OPT_SSC_MOVESYNC
+    // True when the SSC-32 reported the last committed move done (or it is
+    // within cSSC_MOVELEAD ms of its planned end).  Keeps asking, call it
+    // while waiting.
+    boolean FMoveDone(void);
+#endif
     
+#ifdef OPT_ADAPTIVE_MOVETIME
+    // Shortest time (ms) the servos can make the moves of the frame being built
+    // in at cSERVO_MAXSPEED, 0xffff when we do not know where they are now
+    word WMinMoveTime(void);
+#endif
+
+#ifdef OPT_SSC_DELTAUPDATES
+    // Statistics of the delta updates
+    inline unsigned long CFramesSent(void) {return _cFramesSent;};
+    inline unsigned long CServosSkipped(void) {return _cServosSkipped;};
+    inline unsigned long CbSaved(void) {return _cbSaved;};
+#endif
+
 #ifdef OPT_FIND_SERVO_OFFSETS
     void FindServoOffsets(void);  // Needs to be different depending on which driver
 #endif    
@@ -50,11 +150,86 @@ class ServoDriver {
 #endif
 
   private:
+    // The OutputServoInfo functions format the group move into _pbFrame and
+    // CommitServoDriver sends the whole frame at once.
+    void    FrameAddServo(byte bPin, word wPulse);
+#ifdef OPT_IK_CACHE
+    boolean FLegPulsesKept(byte LegIndex, const short *psAngle1, word *pwPulse);
+    void    LegPulsesKeep(byte LegIndex, const short *psAngle1, const word *pwPulse);
+#endif
+    void    FrameSend(void);
+
+    // One critical section per frame: the input controller is asked to hold
+    // off its interrupts from the first byte of a frame to the last.
+    void    TxBeginFrame(void);
+    void    TxEndFrame(void);
+
+    boolean SSCQueryStart(byte bFor, byte cbReply, word wEOL, word wTimeoutMS);
+    byte    SSCQueryPoll(void);
+    void    SSCQueryWait(void);
+    void    SSCQueryEnd(void);
+#ifdef OPT_GPPLAYER
+    void    GPQueryDone(void);
+    void    GPDone(void);
+#endif
+
+    byte    _aabFrame[SSC_NUMFRAMEBUFS][SSC_FRAMESIZE];
+    byte    *_pbFrame;              // buffer the next frame is built in
+    word    _cbFrame;
+    boolean _fTxFrame;              // frame critical section is active
+
+#if defined(OPT_SSC_DELTAUPDATES) || defined(OPT_ADAPTIVE_MOVETIME)
+    // Last pulse sent to each SSC-32 channel
+    word    _awShadow[SSC_NUMCHANNELS];
+#endif
+#ifdef OPT_ADAPTIVE_MOVETIME
+    boolean _fPosKnown;             // the servos are where _awShadow says
+    word    _wMaxDelta;             // us, largest pulse change in the frame being built
+#endif
+#ifdef OPT_SSC_DELTAUPDATES
+    // Servos that did not change are left out of the frame, and every
+    // cSSC_FULLREFRESH frames all are sent.
+    byte    _bFramesToRefresh;      // frames until the next full frame, 0 = this one
+    boolean _fFullFrame;            // frame being built sends all servos
+    unsigned long _cFramesSent;
+    unsigned long _cServosSkipped;
+    unsigned long _cbSaved;
+#endif
+
+#ifdef OPT_IK_CACHE
+    // Angles each leg got last and their pulses, a leg that kept its angles
+    // keeps its pulses
+    short   _aasLegAngle1[6][NUMSERVOSPERLEG];
+    word    _aawLegPulse[6][NUMSERVOSPERLEG];
+    byte    _bLegPulsesValid;       // bit per leg
+#endif
+
+    byte    _bQState;               // SSCQ_xxx
+    byte    _bQFor;                 // SSCQFOR_xxx
+    byte    _cbQWant;
+    byte    _cbQReply;
+    word    _wQEOL;
+    unsigned long _ulQTime;         // micros() of the query or of its last byte
+    unsigned long _ulQTimeout;
+    byte    _abQReply[SSC_QUERYSIZE];
+
+#ifdef OPT_SSC_MOVESYNC
+    void    MoveQueryDone(void);
+    byte    _bMoveSync;             // MOVESYNC_xxx
+    unsigned long _ulMoveEnd;       // millis() the move should be done
+    unsigned long _ulMoveQTime;     // millis() of the last "Q" reply
+#endif
   
 #ifdef OPT_GPPLAYER    
     boolean _fGPEnabled;     // IS GP defined for this servo driver?
-    boolean _fGPActive;      // Is a sequence currently active - May change later when we integrate in sequence timing adjustment code
+    byte    _bGPState;       // GPSTATE_xxx
     uint8_t    _iSeq;        // current sequence we are running
+    short   _sGPSpeed;
+    unsigned long _ulGPTime; // millis() of the last command to the player
+    byte    _abGPStat[4];    // QPL0 reply: sequence, from step, to step, time
+    byte    _bGPSeqDefined;  // bit per sequence found in the SSC-32 EEPROM
+    byte    _iGPScan;        // next sequence to look up
+    unsigned long _ulFrameTime; // millis() of the last frame sent
 #endif
 
 } ;   
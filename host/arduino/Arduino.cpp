@@ -0,0 +1,259 @@
+//==============================================================================
+// Arduino.cpp - Host (Linux) implementation of the Arduino core stand-in.
+//==============================================================================
+#include <stdio.h>
+#include <time.h>
+#include "Arduino.h"
+#include "ArduinoHost.h"
+
+//=============================================================================
+// Virtual clock
+//=============================================================================
+static unsigned long long s_nsStart;
+static unsigned long long s_nsOffset;       // time added by waits
+static unsigned long long s_nsDelay;        // of which delay()
+static unsigned long long s_nsTxBlock;      // of which blocked serial writes
+static bool               s_fDeterministic;
+
+static unsigned long long HostRawNanos(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long long)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+unsigned long long HostNanos(void)
+{
+    if (s_fDeterministic)
+        return s_nsOffset;
+    unsigned long long ns = HostRawNanos();
+    if (!s_nsStart)
+        s_nsStart = ns;
+    return ns - s_nsStart + s_nsOffset;
+}
+
+void HostSetDeterministic(bool fDeterministic)
+{
+    s_fDeterministic = fDeterministic;
+}
+
+void HostAdvanceNanos(unsigned long long ns)
+{
+    s_nsOffset += ns;
+}
+
+unsigned long long HostDelayNanos(void)
+{
+    return s_nsDelay;
+}
+
+unsigned long long HostTxBlockNanos(void)
+{
+    return s_nsTxBlock;
+}
+
+unsigned long millis(void)
+{
+    if (s_fDeterministic)
+        s_nsOffset += 100;
+    return (unsigned long)(HostNanos() / 1000000ULL);
+}
+
+unsigned long micros(void)
+{
+    if (s_fDeterministic)
+        s_nsOffset += 100;
+    return (unsigned long)(HostNanos() / 1000ULL);
+}
+
+void delay(unsigned long ms)
+{
+    s_nsDelay += ms * 1000000ULL;
+    HostAdvanceNanos(ms * 1000000ULL);
+}
+
+void delayMicroseconds(unsigned int us)
+{
+    s_nsDelay += us * 1000ULL;
+    HostAdvanceNanos(us * 1000ULL);
+}
+
+//=============================================================================
+// Pins
+//=============================================================================
+static uint8_t  s_abPinLevel[64];
+static bool     s_fPinLevelInit;
+static volatile uint32_t s_aulPorts[8];
+
+void HostSetPinLevel(uint8_t pin, uint8_t val)
+{
+    if (!s_fPinLevelInit) {
+        memset(s_abPinLevel, HIGH, sizeof(s_abPinLevel));
+        s_fPinLevelInit = true;
+    }
+    s_abPinLevel[pin & 63] = val;
+}
+
+void pinMode(uint8_t pin, uint8_t mode)
+{
+}
+
+void digitalWrite(uint8_t pin, uint8_t val)
+{
+}
+
+int digitalRead(uint8_t pin)
+{
+    if (!s_fPinLevelInit)
+        return HIGH;
+    return s_abPinLevel[pin & 63];
+}
+
+int analogRead(uint8_t pin)
+{
+    return 1023;
+}
+
+volatile uint32_t *portOutputRegister(uint8_t port)
+{
+    return &s_aulPorts[port & 7];
+}
+
+//=============================================================================
+// Print
+//=============================================================================
+size_t Print::write(const uint8_t *pb, size_t cb)
+{
+    size_t n = 0;
+    while (cb--)
+        n += write(*pb++);
+    return n;
+}
+
+size_t Print::print(long n, int base)
+{
+    if ((n < 0) && (base == DEC))
+        return write('-') + print((unsigned long)-n, base);
+    return print((unsigned long)n, base);
+}
+
+size_t Print::print(unsigned long n, int base)
+{
+    char sz[8 * sizeof(long) + 1];
+    char *psz = &sz[sizeof(sz) - 1];
+    if (base < 2)
+        base = 10;
+    *psz = '\0';
+    do {
+        unsigned d = n % base;
+        n /= base;
+        *--psz = (char)(d < 10 ? '0' + d : 'A' + d - 10);
+    } while (n);
+    return write(psz);
+}
+
+size_t Print::print(double d, int digits)
+{
+    char sz[32];
+    snprintf(sz, sizeof(sz), "%.*f", digits, d);
+    return write(sz);
+}
+
+//=============================================================================
+// HardwareSerial
+//=============================================================================
+HardwareSerial Serial;
+HardwareSerial Serial1;
+
+HardwareSerial::HardwareSerial(void)
+    : _pfnTxHook(0), _cbTxRing(64), _nsPerByte(0), _nsTxDone(0), _cbTxTotal(0),
+      _iRxHead(0), _iRxTail(0)
+{
+}
+
+void HardwareSerial::begin(unsigned long ulBaud)
+{
+    _nsPerByte = 10ULL * 1000000000ULL / ulBaud;    // start + 8 data + stop bits
+}
+
+unsigned HardwareSerial::_TxQueued(unsigned long long nsNow)
+{
+    if (!_nsPerByte || (_nsTxDone <= nsNow))
+        return 0;
+    return (unsigned)((_nsTxDone - nsNow + _nsPerByte - 1) / _nsPerByte);
+}
+
+int HardwareSerial::availableForWrite(void)
+{
+    return (int)(_cbTxRing - min(_TxQueued(HostNanos()), _cbTxRing));
+}
+
+size_t HardwareSerial::write(uint8_t b)
+{
+    return write(&b, 1);
+}
+
+size_t HardwareSerial::write(const uint8_t *pb, size_t cb)
+{
+    if (_nsPerByte) {
+        for (size_t i = 0; i < cb; i++) {
+            unsigned long long nsNow = HostNanos();
+            if (_nsTxDone < nsNow)
+                _nsTxDone = nsNow;
+            _nsTxDone += _nsPerByte;
+            // Block until the byte fits in the TX ring
+            unsigned cbQueued = _TxQueued(nsNow);
+            if (cbQueued > _cbTxRing) {
+                unsigned long long nsWait = (unsigned long long)(cbQueued - _cbTxRing) * _nsPerByte;
+                s_nsTxBlock += nsWait;
+                HostAdvanceNanos(nsWait);
+            }
+        }
+    }
+    _cbTxTotal += cb;
+    if (_pfnTxHook)
+        (*_pfnTxHook)(pb, cb);
+    return cb;
+}
+
+void HardwareSerial::flush(void)
+{
+    // Arduino 1.0+ semantics: wait for the outgoing data to leave the wire
+    unsigned long long nsNow = HostNanos();
+    if (_nsTxDone > nsNow) {
+        s_nsTxBlock += _nsTxDone - nsNow;
+        HostAdvanceNanos(_nsTxDone - nsNow);
+    }
+}
+
+int HardwareSerial::available(void)
+{
+    return (int)((_iRxHead - _iRxTail) % sizeof(_abRx));
+}
+
+int HardwareSerial::read(void)
+{
+    if (_iRxHead == _iRxTail)
+        return -1;
+    uint8_t b = _abRx[_iRxTail];
+    _iRxTail = (_iRxTail + 1) % sizeof(_abRx);
+    return b;
+}
+
+int HardwareSerial::peek(void)
+{
+    if (_iRxHead == _iRxTail)
+        return -1;
+    return _abRx[_iRxTail];
+}
+
+void HardwareSerial::hostQueueRx(const uint8_t *pb, size_t cb)
+{
+    while (cb--) {
+        unsigned iNext = (_iRxHead + 1) % sizeof(_abRx);
+        if (iNext == _iRxTail)
+            return;     // overflow, drop like the real driver
+        _abRx[_iRxHead] = *pb++;
+        _iRxHead = iNext;
+    }
+}
@@ -0,0 +1,175 @@
+//==============================================================================
+// Arduino.h - Host (Linux) stand-in for the Arduino core.
+//
+// Just enough of the Arduino 1.x API for the Hexapod_Apod sketch to compile
+// and run unchanged on a PC.  Time is virtual: delay()/delayMicroseconds()
+// advance the clock without sleeping, and the serial ports model the wire
+// time of the bytes written to them (see ArduinoHost.h).
+//
+// Note: on AVR an int is 16 bits and a long is 32 bits.  On the host they
+// are 32 and 64 bits, so arithmetic that silently overflows on the robot
+// does not overflow here.
+//==============================================================================
+#ifndef _HOST_ARDUINO_H_
+#define _HOST_ARDUINO_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+typedef uint8_t     byte;
+typedef bool        boolean;
+typedef uint16_t    word;
+
+#define HIGH        1
+#define LOW         0
+#define INPUT       0
+#define OUTPUT      1
+#define INPUT_PULLUP 2
+
+#define DEC         10
+#define HEX         16
+#define OCT         8
+#define BIN         2
+
+// The host build poses as a board with a second hardware UART (like the
+// Mega), so Hex_Cfg.h routes SSCSerial to Serial1.
+#define UBRR1H      1
+
+//-----------------------------------------------------------------------------
+// Program memory - everything lives in RAM on the host
+//-----------------------------------------------------------------------------
+#define PROGMEM
+#define PSTR(s)                 (s)
+#define F(s)                    (s)
+#define pgm_read_byte(addr)     (*(const uint8_t *)(addr))
+#define pgm_read_word(addr)     (*(const uint16_t *)(addr))
+// Four bytes like on the AVR, also out of a table of (64 bit) longs; signed,
+// so a (long) of it is the same 32 bits with the sign as on the AVR
+static inline int32_t HostReadDword(const void *pv) { int32_t l; memcpy(&l, pv, sizeof(l)); return l; }
+#define pgm_read_dword(addr)    HostReadDword(addr)
+#define pgm_read_ptr(addr)      (*(void * const *)(addr))
+
+//-----------------------------------------------------------------------------
+// Arduino helper macros (same macro semantics as the AVR core)
+//-----------------------------------------------------------------------------
+#ifdef abs
+#undef abs
+#endif
+#define min(a,b)                ((a)<(b)?(a):(b))
+#define max(a,b)                ((a)>(b)?(a):(b))
+#define abs(x)                  ((x)>0?(x):-(x))
+#define constrain(amt,low,high) ((amt)<(low)?(low):((amt)>(high)?(high):(amt)))
+#define lowByte(w)              ((uint8_t)((w) & 0xff))
+#define highByte(w)             ((uint8_t)((w) >> 8))
+
+#define noInterrupts()
+#define interrupts()
+
+//-----------------------------------------------------------------------------
+// Time
+//-----------------------------------------------------------------------------
+unsigned long millis(void);
+unsigned long micros(void);
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+
+//-----------------------------------------------------------------------------
+// Pins
+//-----------------------------------------------------------------------------
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t val);
+int  digitalRead(uint8_t pin);
+int  analogRead(uint8_t pin);
+
+volatile uint32_t *portOutputRegister(uint8_t port);
+#define digitalPinToPort(pin)       ((uint8_t)((pin) / 8))
+#define digitalPinToBitMask(pin)    ((uint16_t)(1 << ((pin) % 8)))
+
+//-----------------------------------------------------------------------------
+// Print / Stream
+//-----------------------------------------------------------------------------
+class Print {
+  public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t b) = 0;
+    virtual size_t write(const uint8_t *pb, size_t cb);
+    size_t write(const char *psz) { return psz ? write((const uint8_t *)psz, strlen(psz)) : 0; }
+    size_t write(const char *pb, size_t cb) { return write((const uint8_t *)pb, cb); }
+    size_t write(int n) { return write((uint8_t)n); }
+    size_t write(unsigned int n) { return write((uint8_t)n); }
+    size_t write(long n) { return write((uint8_t)n); }
+    size_t write(unsigned long n) { return write((uint8_t)n); }
+
+    size_t print(const char *psz) { return write(psz); }
+    size_t print(char c) { return write((uint8_t)c); }
+    size_t print(unsigned char b, int base = DEC) { return print((unsigned long)b, base); }
+    size_t print(int n, int base = DEC) { return print((long)n, base); }
+    size_t print(unsigned int n, int base = DEC) { return print((unsigned long)n, base); }
+    size_t print(long n, int base = DEC);
+    size_t print(unsigned long n, int base = DEC);
+    size_t print(double d, int digits = 2);
+
+    size_t println(void) { return write("\r\n"); }
+    template <typename T> size_t println(T v) { size_t n = print(v); return n + println(); }
+    template <typename T> size_t println(T v, int base) { size_t n = print(v, base); return n + println(); }
+};
+
+class Stream : public Print {
+  public:
+    virtual int available(void) = 0;
+    virtual int read(void) = 0;
+    virtual int peek(void) = 0;
+    virtual void flush(void) = 0;
+};
+
+//-----------------------------------------------------------------------------
+// HardwareSerial - a UART with a TX ring that drains at the configured baud
+// rate in virtual time.  Writing to a full ring blocks (advances the clock)
+// the same way the AVR core does.
+//-----------------------------------------------------------------------------
+class HardwareSerial : public Stream {
+  public:
+    HardwareSerial(void);
+    void begin(unsigned long ulBaud);
+    void end(void) {}
+    bool listen(void) { return true; }
+
+    virtual int available(void);
+    virtual int read(void);
+    virtual int peek(void);
+    virtual void flush(void);
+    int availableForWrite(void);
+    virtual size_t write(uint8_t b);
+    virtual size_t write(const uint8_t *pb, size_t cb);
+    using Print::write;
+    operator bool() { return true; }
+
+    // Host side hooks
+    typedef void (*PFNTXHOOK)(const uint8_t *pb, size_t cb);
+    void hostSetTxHook(PFNTXHOOK pfn) { _pfnTxHook = pfn; }
+    void hostSetTxRingSize(unsigned cb) { _cbTxRing = cb; }
+    void hostSetNoWireTime(void) { _nsPerByte = 0; }
+    void hostQueueRx(const uint8_t *pb, size_t cb);
+    unsigned long hostTxBytes(void) { return _cbTxTotal; }
+    unsigned long long hostTxDoneNs(void) { return _nsTxDone; }
+    unsigned long long hostNsPerByte(void) { return _nsPerByte; }
+
+  private:
+    unsigned            _TxQueued(unsigned long long nsNow);
+    PFNTXHOOK           _pfnTxHook;
+    unsigned            _cbTxRing;
+    unsigned long long  _nsPerByte;
+    unsigned long long  _nsTxDone;      // virtual time the last queued byte leaves the wire
+    unsigned long       _cbTxTotal;
+    uint8_t             _abRx[512];
+    unsigned            _iRxHead;
+    unsigned            _iRxTail;
+};
+
+extern HardwareSerial Serial;
+extern HardwareSerial Serial1;
+
+#endif // _HOST_ARDUINO_H_
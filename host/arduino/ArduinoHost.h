@@ -0,0 +1,35 @@
+//==============================================================================
+// ArduinoHost.h - Host-only side of the Arduino stand-in.  Used by the
+// harness (not by the sketch) to drive and observe the virtual machine.
+//
+// The virtual clock is the host's own elapsed time plus everything that was
+// "waited": delay()/delayMicroseconds() and serial writes that would have
+// blocked on the real board.  So micros() differences inside the sketch show
+// real host compute time plus modeled wait time.
+//==============================================================================
+#ifndef _ARDUINO_HOST_H_
+#define _ARDUINO_HOST_H_
+
+#include <stdint.h>
+
+// Virtual time in nanoseconds since start.
+unsigned long long HostNanos(void);
+
+// Deterministic mode: leave the host's own compute time out of the clock so
+// runs are repeatable.  Every clock read then costs a fixed 100 ns instead,
+// which keeps busy-wait loops in the sketch terminating.
+void HostSetDeterministic(bool fDeterministic);
+
+// Advance the virtual clock without doing anything.
+void HostAdvanceNanos(unsigned long long ns);
+
+// Total virtual time spent inside delay()/delayMicroseconds().
+unsigned long long HostDelayNanos(void);
+
+// Total virtual time spent blocked on full serial TX rings.
+unsigned long long HostTxBlockNanos(void);
+
+// Digital input levels seen by digitalRead() (default HIGH for every pin).
+void HostSetPinLevel(uint8_t pin, uint8_t val);
+
+#endif // _ARDUINO_HOST_H_
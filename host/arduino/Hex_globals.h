@@ -0,0 +1,5 @@
+//==============================================================================
+// Hex_globals.h - The sketch includes "Hex_globals.h" which only resolves on
+// case insensitive file systems.  Forward to the real header.
+//==============================================================================
+#include <Hex_Globals.h>
@@ -0,0 +1,77 @@
+//==============================================================================
+// PS2X_lib.cpp - Host stand-in for the PS2X library (scripted pad).
+//==============================================================================
+#include "PS2X_lib.h"
+
+static uint16_t s_wButtons;
+static byte     s_abSticks[4] = {128, 128, 128, 128};    // LX, LY, RX, RY
+static boolean  s_fConnected = true;
+
+void PS2XStubSetState(uint16_t wButtons, byte bLX, byte bLY, byte bRX, byte bRY)
+{
+    s_wButtons = wButtons;
+    s_abSticks[0] = bLX;
+    s_abSticks[1] = bLY;
+    s_abSticks[2] = bRX;
+    s_abSticks[3] = bRY;
+}
+
+void PS2XStubSetConnected(boolean fConnected)
+{
+    s_fConnected = fConnected;
+}
+
+byte PS2X::config_gamepad(uint8_t clk, uint8_t cmd, uint8_t att, uint8_t dat, bool pressures, bool rumble)
+{
+    _wButtons = 0;
+    _wPrevButtons = 0;
+    memset(_abAnalog, 128, sizeof(_abAnalog));
+    return 0;
+}
+
+void PS2X::read_gamepad(void)
+{
+    _wPrevButtons = _wButtons;
+    _wButtons = s_wButtons;
+    _abAnalog[1] = s_fConnected ? 0x73 : 0x41;
+    _abAnalog[PSS_LX] = s_abSticks[0];
+    _abAnalog[PSS_LY] = s_abSticks[1];
+    _abAnalog[PSS_RX] = s_abSticks[2];
+    _abAnalog[PSS_RY] = s_abSticks[3];
+}
+
+boolean PS2X::read_gamepad(boolean motor1, byte motor2)
+{
+    read_gamepad();
+    return true;
+}
+
+boolean PS2X::Button(uint16_t wMask)
+{
+    return (_wButtons & wMask) != 0;
+}
+
+boolean PS2X::ButtonPressed(unsigned int wMask)
+{
+    return ((_wButtons & ~_wPrevButtons) & wMask) != 0;
+}
+
+boolean PS2X::ButtonReleased(unsigned int wMask)
+{
+    return ((~_wButtons & _wPrevButtons) & wMask) != 0;
+}
+
+boolean PS2X::NewButtonState(void)
+{
+    return _wButtons != _wPrevButtons;
+}
+
+unsigned int PS2X::ButtonDataByte(void)
+{
+    return (unsigned int)(uint16_t)~_wButtons;
+}
+
+byte PS2X::Analog(byte bIndex)
+{
+    return (bIndex < sizeof(_abAnalog)) ? _abAnalog[bIndex] : 128;
+}
@@ -0,0 +1,64 @@
+//==============================================================================
+// PS2X_lib.h - Host stand-in for Bill Porter's PS2X library.  The pad state
+// is whatever the harness last scripted with PS2XStubSetState().
+//==============================================================================
+#ifndef _HOST_PS2X_LIB_H_
+#define _HOST_PS2X_LIB_H_
+
+#include "Arduino.h"
+
+// Button masks (same values as PS2X_lib)
+#define PSB_SELECT      0x0001
+#define PSB_L3          0x0002
+#define PSB_R3          0x0004
+#define PSB_START       0x0008
+#define PSB_PAD_UP      0x0010
+#define PSB_PAD_RIGHT   0x0020
+#define PSB_PAD_DOWN    0x0040
+#define PSB_PAD_LEFT    0x0080
+#define PSB_L2          0x0100
+#define PSB_R2          0x0200
+#define PSB_L1          0x0400
+#define PSB_R1          0x0800
+#define PSB_GREEN       0x1000
+#define PSB_RED         0x2000
+#define PSB_BLUE        0x4000
+#define PSB_PINK        0x8000
+#define PSB_TRIANGLE    0x1000
+#define PSB_CIRCLE      0x2000
+#define PSB_CROSS       0x4000
+#define PSB_SQUARE      0x8000
+
+// Analog stick indexes (same values as PS2X_lib)
+#define PSS_RX          5
+#define PSS_RY          6
+#define PSS_LX          7
+#define PSS_LY          8
+
+class PS2X {
+  public:
+    byte    config_gamepad(uint8_t clk, uint8_t cmd, uint8_t att, uint8_t dat,
+                           bool pressures = false, bool rumble = false);
+    void    read_gamepad(void);
+    boolean read_gamepad(boolean motor1, byte motor2);
+    boolean Button(uint16_t wMask);
+    boolean ButtonPressed(unsigned int wMask);
+    boolean ButtonReleased(unsigned int wMask);
+    boolean NewButtonState(void);
+    unsigned int ButtonDataByte(void);
+    byte    Analog(byte bIndex);
+
+  private:
+    uint16_t    _wButtons;
+    uint16_t    _wPrevButtons;
+    byte        _abAnalog[9];
+};
+
+// Host side: set what the next read_gamepad() returns.  Buttons are a mask of
+// PSB_* values currently held; sticks are 0-255 with 128 centered.
+void PS2XStubSetState(uint16_t wButtons, byte bLX, byte bLY, byte bRX, byte bRY);
+
+// Host side: make the pad look disconnected (digital mode) to the sketch.
+void PS2XStubSetConnected(boolean fConnected);
+
+#endif // _HOST_PS2X_LIB_H_
@@ -0,0 +1,15 @@
+//==============================================================================
+// SoftwareSerial.h - Host stand-in.  The host build routes SSCSerial to the
+// modeled hardware port Serial1, so this class only has to exist.
+//==============================================================================
+#ifndef _HOST_SOFTWARE_SERIAL_H_
+#define _HOST_SOFTWARE_SERIAL_H_
+
+#include "Arduino.h"
+
+class SoftwareSerial : public HardwareSerial {
+  public:
+    SoftwareSerial(uint8_t bRxPin, uint8_t bTxPin) {}
+};
+
+#endif // _HOST_SOFTWARE_SERIAL_H_
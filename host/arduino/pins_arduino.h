@@ -0,0 +1,3 @@
+//==============================================================================
+// pins_arduino.h - Host stand-in (pin mapping macros live in Arduino.h).
+//==============================================================================
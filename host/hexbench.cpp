@@ -0,0 +1,785 @@
+//==============================================================================
+// hexbench.cpp - Cycle time benchmark for the Hexapod_Apod sketch on the host.
+//
+// Runs setup() and then loop() through a scripted PS2 session (power on,
+// stand, walk with each gait, balance, body shift/rotate, power off) against
+// the modeled SSC-32, and reports the time per control cycle split into the
+// loop() stages.  Stage boundaries come from -finstrument-functions on the
+// sketch sources, so the sketch itself is compiled unchanged.
+//
+// Times are virtual microseconds: real host compute time plus the modeled
+// waits (delay() and serial TX backpressure at the configured baud rates).
+//
+//   hexbench [-d] [-n] [-v] [-m]
+//     -d   deterministic clock (leave host compute time out); use this to
+//          compare the SSC-32 output digest between builds
+//     -n   no wire time on the SSC-32 port, shows the pure compute cost
+//     -v   echo the sketch's debug serial output
+//     -m   instead of the script, sweep GetATan2/GetArcCos, LegIK and BodyFK
+//          against libm and time them (whichever versions are compiled in);
+//          fails when BodyFK drifts from the decimal math by more than 1 mm,
+//          when Hex_Trig.h does not build the sketch's own tables, or when
+//          GetSinCos, GetArcCos, GetATan2, BodyFK or LegIK return anything
+//          else than the original global-variable versions in refmath.cpp
+//          (over all their inputs, in the builds that use the same math)
+//==============================================================================
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "Arduino.h"
+#include "ArduinoHost.h"
+#include "PS2X_lib.h"
+#include "ssc32_sim.h"
+#include "Hex_Globals.h"
+#include "Hex_IKTable.h"
+#include "Hex_Trig.h"
+#include "refmath.h"
+
+extern void setup(void);
+extern void loop(void);
+
+// Sketch functions that make up the loop() stages
+extern void GaitSeq(void);
+extern void BalCalcOneLeg(short PosX, short PosZ, short PosY, byte BalLegNr);
+extern void BalanceBody(void);
+extern void BodyRotUpdate(BODYROT *pBodyRot, short RotX1, long RotY1, short RotZ1);
+extern COORD3D BodyFK(BODYROT *pBodyRot, short PosX, short PosZ, short PosY, short RotationY, byte BodyIKLeg);
+extern LEGIKSOLUTION LegIK(short IKFeetPosX, short IKFeetPosY, short IKFeetPosZ, byte LegIKLegNr);
+extern void CheckAngles(void);
+extern void StartUpdateServos(void);
+extern long GetArcCos(short cos4);
+extern SINCOS GetSinCos(short AngleDeg1);
+extern ATAN2 GetATan2(short AtanX, short AtanY);
+extern void InitLegIKConst(void);
+#ifdef OPT_LEGTEMPLATES
+extern void LegsIK(void);
+#endif
+extern LEGIKCONST LegIKConst[6];
+extern short BodyRotOffsetX;
+extern short BodyRotOffsetY;
+extern short BodyRotOffsetZ;
+extern long TotalXBal1;
+extern long TotalYBal1;
+extern long TotalZBal1;
+#if defined(OPT_FIXEDPOINT) && defined(QNUM_CHECK)
+extern unsigned long g_cQNumOverflows;
+#endif
+
+//=============================================================================
+// Stage attribution
+//=============================================================================
+enum {
+    STAGE_INPUT = 0,
+    STAGE_GAIT,
+    STAGE_BALANCE,
+    STAGE_IK,
+    STAGE_SERVO,
+    NUM_STAGES
+};
+
+static const char * const s_apszStageNames[NUM_STAGES] = {
+    "Input", "GaitSeq", "Balance", "FK/IK", "Servo"
+};
+
+typedef struct {
+    void   *pvFn;
+    int     iStage;
+} STAGEFN;
+
+#define MAX_STAGEFNS    12
+static STAGEFN             s_aStageFns[MAX_STAGEFNS];
+static int                 s_cStageFns;
+
+static int                 s_iStageActive = -1;
+static void               *s_pvStageFn;
+static unsigned long long  s_nsStageStart;
+static unsigned long long  s_nsStageDelayStart;
+static unsigned long long  s_ansStage[NUM_STAGES];     // accumulated this scenario
+static unsigned long long  s_nsStageDelay;             // delay() time inside stages
+
+extern "C" {
+void __cyg_profile_func_enter(void *pvFn, void *pvCallSite) __attribute__((no_instrument_function));
+void __cyg_profile_func_exit(void *pvFn, void *pvCallSite) __attribute__((no_instrument_function));
+
+void __cyg_profile_func_enter(void *pvFn, void *pvCallSite)
+{
+    if (s_iStageActive >= 0)
+        return;
+    for (int i = 0; i < s_cStageFns; i++) {
+        if (s_aStageFns[i].pvFn == pvFn) {
+            s_iStageActive = s_aStageFns[i].iStage;
+            s_pvStageFn = pvFn;
+            s_nsStageStart = HostNanos();
+            s_nsStageDelayStart = HostDelayNanos();
+            return;
+        }
+    }
+}
+
+void __cyg_profile_func_exit(void *pvFn, void *pvCallSite)
+{
+    if ((s_iStageActive >= 0) && (pvFn == s_pvStageFn)) {
+        s_ansStage[s_iStageActive] += HostNanos() - s_nsStageStart;
+        s_nsStageDelay += HostDelayNanos() - s_nsStageDelayStart;
+        s_iStageActive = -1;
+    }
+}
+}
+
+static void AddStageFn(void *pvFn, int iStage)
+{
+    s_aStageFns[s_cStageFns].pvFn = pvFn;
+    s_aStageFns[s_cStageFns].iStage = iStage;
+    s_cStageFns++;
+}
+
+typedef void (*PFNINPUT)(InputController *);
+typedef void (*PFNCOMMIT)(ServoDriver *, word);
+typedef void (*PFNFREE)(ServoDriver *);
+
+static void InitStageFns(void)
+{
+    // Bound member function pointers -> plain function addresses (GCC extension)
+    AddStageFn((void *)(PFNINPUT)(g_InputController.*(&InputController::ControlInput)), STAGE_INPUT);
+    AddStageFn((void *)&GaitSeq, STAGE_GAIT);
+    AddStageFn((void *)&BalCalcOneLeg, STAGE_BALANCE);
+    AddStageFn((void *)&BalanceBody, STAGE_BALANCE);
+    AddStageFn((void *)&BodyFK, STAGE_IK);
+    AddStageFn((void *)&LegIK, STAGE_IK);
+#ifdef OPT_LEGTEMPLATES
+    AddStageFn((void *)&LegsIK, STAGE_IK);
+#endif
+    AddStageFn((void *)&CheckAngles, STAGE_IK);
+    AddStageFn((void *)&StartUpdateServos, STAGE_SERVO);
+    AddStageFn((void *)(PFNCOMMIT)(g_ServoDriver.*(&ServoDriver::CommitServoDriver)), STAGE_SERVO);
+    AddStageFn((void *)(PFNFREE)(g_ServoDriver.*(&ServoDriver::FreeServos)), STAGE_SERVO);
+}
+
+//=============================================================================
+// PS2 script
+//=============================================================================
+typedef struct {
+    const char *pszName;    // reported scenario name, NULL to run without reporting
+    int         cCycles;
+    uint16_t    wPress;     // buttons pressed on the first cycle only
+    uint16_t    wHold;      // buttons held for the whole step
+    byte        bLX, bLY, bRX, bRY;
+} BENCHSTEP;
+
+static const BENCHSTEP s_aScript[] = {
+    {"off (idle)",          40, 0,            0, 128, 128, 128, 128},
+    {"power on + stand",    60, PSB_START,    0, 128, 128, 128, 128},
+    {"walk tripod 8",      240, 0,            0, 128,   0, 128, 128},
+    {"walk + turn",        120, 0,            0, 128,   0, 200, 128},
+    {"stop",                40, 0,            0, 128, 128, 128, 128},
+    {NULL,                   1, PSB_SELECT,   0, 128, 128, 128, 128},   // -> triple tripod 12
+    {"walk tri-tripod 12", 240, 0,            0, 128,   0, 128, 128},
+    {NULL,                  40, 0,            0, 128, 128, 128, 128},
+    {NULL,                   1, PSB_SELECT,   0, 128, 128, 128, 128},   // -> triple tripod 16
+    {"walk tri-tripod 16", 240, 0,            0, 128,   0, 128, 128},
+    {NULL,                  40, 0,            0, 128, 128, 128, 128},
+    {NULL,                   1, PSB_SELECT,   0, 128, 128, 128, 128},   // -> wave 24
+    {"walk wave 24",       240, 0,            0, 128,   0, 128, 128},
+    {NULL,                  40, 0,            0, 128, 128, 128, 128},
+    {NULL,                   1, PSB_SQUARE,   0, 128, 128, 128, 128},   // balance mode on
+    {"walk + balance",     240, 0,            0, 128,   0, 128, 128},
+    {NULL,                  40, 0,            0, 128, 128, 128, 128},
+    {NULL,                   1, PSB_SQUARE,   0, 128, 128, 128, 128},   // balance mode off
+    {"body shift",          60, PSB_L1,       0, 200, 100,  60, 180},
+    {"body rotate",         60, PSB_L2,       0,  60, 200, 180, 128},
+    {NULL,                   1, PSB_CROSS,    0, 128, 128, 128, 128},   // GP player mode
+    {"GP sequence",        100, PSB_R2,       0, 128, 128, 128, 128},
+    {"GP 50% + cancel",     60, PSB_R2,       0, 128, 128, 128, 200},
+    {NULL,                   1, PSB_R2,       0, 128, 128, 128, 200},   // cancel
+    {NULL,                   1, PSB_CROSS,    0, 128, 128, 128, 128},   // walk mode
+    {"power off",           40, PSB_START,    0, 128, 128, 128, 128},
+};
+
+//=============================================================================
+// Reporting
+//=============================================================================
+typedef struct {
+    unsigned long       cCycles;
+    unsigned long long  nsTotal;
+    unsigned long long  nsMax;
+    unsigned long long  nsDelay;
+    unsigned long long  nsTxBlock;
+    unsigned long       cbSSC;
+    unsigned long       cGroupMoves;
+} SCENARIO;
+
+static void PrintHeader(void)
+{
+    printf("%-20s %6s %9s %9s", "scenario", "cycles", "avg(us)", "max(us)");
+    for (int i = 0; i < NUM_STAGES; i++)
+        printf(" %9s", s_apszStageNames[i]);
+    printf(" %9s %9s %8s %7s %7s\n", "Idle", "Other", "SSC B/c", "moves", "TX ovl");
+}
+
+static void PrintScenario(const char *pszName, const SCENARIO *ps)
+{
+    unsigned long c = ps->cCycles ? ps->cCycles : 1;
+    unsigned long long nsStages = 0;
+    unsigned long long nsIdle = ps->nsDelay - s_nsStageDelay;
+
+    printf("%-20s %6lu %9.1f %9.1f", pszName, ps->cCycles, ps->nsTotal / 1000.0 / c, ps->nsMax / 1000.0);
+    for (int i = 0; i < NUM_STAGES; i++) {
+        printf(" %9.1f", s_ansStage[i] / 1000.0 / c);
+        nsStages += s_ansStage[i];
+    }
+    printf(" %9.1f %9.1f %8.1f %7lu", nsIdle / 1000.0 / c,
+           ((double)ps->nsTotal - (double)nsStages - (double)nsIdle) / 1000.0 / c,
+           (double)ps->cbSSC / c, ps->cGroupMoves);
+
+    // Share of the SSC-32 wire time the sketch did not spend blocked on the
+    // UART, i.e. transmission that overlapped computing or waiting
+    double nsWire = (double)ps->cbSSC * Serial1.hostNsPerByte();
+    if (nsWire > 0)
+        printf(" %6.1f%%\n", 100.0 * (1.0 - min(ps->nsTxBlock / nsWire, 1.0)));
+    else
+        printf(" %7s\n", "-");
+}
+
+//=============================================================================
+// Math sweep
+//=============================================================================
+typedef struct {
+    double  dMax;
+    double  dSum;
+    long    c;
+} ERRSTAT;
+
+static void AddErr(ERRSTAT *pe, double dErr)
+{
+    dErr = fabs(dErr);
+    if (dErr > pe->dMax)
+        pe->dMax = dErr;
+    pe->dSum += dErr;
+    pe->c++;
+}
+
+static double RealNanos(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+#define MATHTIMECALLS   (1 << 16)
+static volatile long s_lMathSink;
+
+// BodyFK the way the sketch does it in decimals (sin/cos times c4DEC, mm
+// times c2DEC), from the center of rotation to the feet CPR.  OPT_FIXEDPOINT
+// has to stay within cFKMAXDRIFT of it.
+#define cFKMAXDRIFT     1       // mm
+
+static short DecSin4(int Angle1)
+{
+    return (short)lround(sin(Angle1 * M_PI / 1800) * c4DEC);
+}
+
+static COORD3D DecBodyFK(short CPR_X, short CPR_Y, short CPR_Z, int A1, int B1, int G1)
+{
+    long SinA4 = DecSin4(A1), CosA4 = DecSin4(900 - A1);
+    long SinB4 = DecSin4(B1), CosB4 = DecSin4(900 - B1);
+    long SinG4 = DecSin4(G1), CosG4 = DecSin4(900 - G1);
+    COORD3D Pos;
+
+    Pos.x = ((long)CPR_X*c2DEC - ((long)CPR_X*c2DEC*CosA4/c4DEC*CosB4/c4DEC - (long)CPR_Z*c2DEC*CosB4/c4DEC*SinA4/c4DEC
+            + (long)CPR_Y*c2DEC*SinB4/c4DEC ))/c2DEC;
+    Pos.z = ((long)CPR_Z*c2DEC - ( (long)CPR_X*c2DEC*CosG4/c4DEC*SinA4/c4DEC + (long)CPR_X*c2DEC*CosA4/c4DEC*SinB4/c4DEC*SinG4/c4DEC
+            + (long)CPR_Z*c2DEC*CosA4/c4DEC*CosG4/c4DEC - (long)CPR_Z*c2DEC*SinA4/c4DEC*SinB4/c4DEC*SinG4/c4DEC
+            - (long)CPR_Y*c2DEC*CosB4/c4DEC*SinG4/c4DEC ))/c2DEC;
+    Pos.y = ((long)CPR_Y  *c2DEC - ( (long)CPR_X*c2DEC*SinA4/c4DEC*SinG4/c4DEC - (long)CPR_X*c2DEC*CosA4/c4DEC*CosG4/c4DEC*SinB4/c4DEC
+            + (long)CPR_Z*c2DEC*CosA4/c4DEC*SinG4/c4DEC + (long)CPR_Z*c2DEC*CosG4/c4DEC*SinA4/c4DEC*SinB4/c4DEC
+            + (long)CPR_Y*c2DEC*CosB4/c4DEC*CosG4/c4DEC ))/c2DEC;
+    return Pos;
+}
+
+// The same in double
+static void RealBodyFK(double *pd, short CPR_X, short CPR_Y, short CPR_Z, int A1, int B1, int G1)
+{
+    double sA = sin(A1 * M_PI / 1800), cA = cos(A1 * M_PI / 1800);
+    double sB = sin(B1 * M_PI / 1800), cB = cos(B1 * M_PI / 1800);
+    double sG = sin(G1 * M_PI / 1800), cG = cos(G1 * M_PI / 1800);
+
+    pd[0] = CPR_X - (CPR_X*cA*cB - CPR_Z*cB*sA + CPR_Y*sB);
+    pd[1] = CPR_Y - (CPR_X*sA*sG - CPR_X*cA*cG*sB + CPR_Z*cA*sG + CPR_Z*cG*sA*sB + CPR_Y*cB*cG);
+    pd[2] = CPR_Z - (CPR_X*cG*sA + CPR_X*cA*sB*sG + CPR_Z*cA*cG - CPR_Z*sA*sB*sG - CPR_Y*cB*sG);
+}
+
+// The functions against the original ones in refmath.cpp, which left their
+// results in globals.  Only the builds that still do the same math are
+// compared: the generated sin table rounds differently, the fixed point
+// sin/cos have another scale, and CORDIC and the IK table are other math.
+#if !defined(OPT_TRIGTABLES) && !defined(OPT_FIXEDPOINT)
+#define REF_SINCOS
+#endif
+#ifndef OPT_CORDIC_ATAN2
+#define REF_ATAN2
+#endif
+#if defined(REF_ATAN2) && !defined(OPT_FIXEDPOINT) && !defined(OPT_IKTABLE) && (defined(REF_SINCOS) || !defined(c4DOF))
+#define REF_LEGIK
+#endif
+#define REFCALLS        (1L << 20)
+
+#if defined(REF_SINCOS) || defined(REF_LEGIK)
+static unsigned long s_ulRefRand = 1;
+
+static short RefRand(int nMin, int nMax)
+{
+    s_ulRefRand = s_ulRefRand * 1103515245UL + 12345UL;
+    return (short)(nMin + (long)((s_ulRefRand >> 8) % (unsigned long)(nMax - nMin + 1)));
+}
+#endif
+
+static void RefResult(const char *pszName, long cDiff, long c, bool fCompared)
+{
+    if (fCompared)
+        printf("%-34s %10ld of %ld\n", pszName, cDiff, c);
+    else
+        printf("%-34s %10s\n", pszName, "(not this build)");
+}
+
+static int RefSweep(void)
+{
+    long cSinCos = 0, cArcCos = 0, cATan2 = 0, cBodyFK = 0, cLegIK = 0;
+    long nSinCos = 0, nArcCos = 0, nATan2 = 0, nBodyFK = 0, nLegIK = 0;
+
+    printf("\nvs the original global-variable math, results that differ\n");
+#ifdef REF_SINCOS
+    // Every short; the old one mapped -32768 outside of the circle and left
+    // the last result, it is the same angle as -32768 + 10 turns now
+    for (long l = -32767; l <= 32767; l++, nSinCos++) {
+        SINCOS sc = GetSinCos(l), scRef = RefGetSinCos(l);
+        if ((sc.sin4 != scRef.sin4) || (sc.cos4 != scRef.cos4))
+            cSinCos++;
+    }
+    SINCOS scEdge = GetSinCos(-32768), scEdgeRef = RefGetSinCos(-32768 + 36000);
+    if ((scEdge.sin4 != scEdgeRef.sin4) || (scEdge.cos4 != scEdgeRef.cos4))
+        cSinCos++;
+    nSinCos++;
+#endif
+#ifdef REF_ATAN2
+    // Every short; -32768 fell through all the cases of the old one and
+    // left the last result, it is acos(-1) now
+    for (long l = -32767; l <= 32767; l++, nArcCos++) {
+        if (GetArcCos(l) != RefGetArcCos(l))
+            cArcCos++;
+    }
+    if (GetArcCos(-32768) != RefGetArcCos(-c4DEC))
+        cArcCos++;
+    nArcCos++;
+
+    // Every integer point the hyp2 short can hold, except the origin
+    for (int x = -327; x <= 327; x++) {
+        for (int y = -327; y <= 327; y++) {
+            if ((!x && !y) || (x * x + y * y > 327 * 327))
+                continue;
+            ATAN2 at = GetATan2(x, y), atRef = RefGetATan2(x, y);
+            if ((at.atan4 != atRef.atan4) || (at.hyp2 != atRef.hyp2))
+                cATan2++;
+            nATan2++;
+        }
+    }
+#endif
+#ifdef REF_SINCOS
+    // Random body rotations, balance, centers of rotation and feet; every
+    // fourth without tilt and every eighth without any rotation, the shortcuts
+    // BodyFK takes then
+    BODYROT Rot;
+    memset(&Rot, 0, sizeof(Rot));
+    Rot.RotX1 = Rot.RotZ1 = Rot.LegRotY1 = -1;      // nothing looked up yet
+    for (long i = 0; i < REFCALLS; i++, nBodyFK++) {
+        bool fTilt = (i & 3) != 0;
+        bool fTurn = (i & 7) != 0;
+        g_InControlState.BodyRot1.x = fTilt ? RefRand(-300, 300) : 0;
+        g_InControlState.BodyRot1.z = fTilt ? RefRand(-300, 300) : 0;
+        g_InControlState.BodyRot1.y = fTurn ? RefRand(-3600, 3600) : 0;
+        TotalXBal1 = fTilt ? RefRand(-150, 150) : 0;
+        TotalZBal1 = fTilt ? RefRand(-150, 150) : 0;
+        TotalYBal1 = fTurn ? RefRand(-150, 150) : 0;
+        BodyRotOffsetX = RefRand(-60, 60);
+        BodyRotOffsetY = RefRand(-60, 60);
+        BodyRotOffsetZ = RefRand(-60, 60);
+        short PosX = RefRand(-200, 200), PosZ = RefRand(-200, 200), PosY = RefRand(-150, 150);
+        short RotationY = fTurn ? RefRand(-30, 30) : 0;
+        byte bLeg = RefRand(0, 5);
+
+        BodyRotUpdate(&Rot, g_InControlState.BodyRot1.x+TotalXBal1, g_InControlState.BodyRot1.y+TotalYBal1,
+                g_InControlState.BodyRot1.z+TotalZBal1);
+        COORD3D Pos = BodyFK(&Rot, PosX, PosZ, PosY, RotationY, bLeg);
+        COORD3D PosRef = RefBodyFK(PosX, PosZ, PosY, RotationY, bLeg);
+        if ((Pos.x != PosRef.x) || (Pos.y != PosRef.y) || (Pos.z != PosRef.z))
+            cBodyFK++;
+    }
+    memset(&g_InControlState.BodyRot1, 0, sizeof(g_InControlState.BodyRot1));
+    TotalXBal1 = TotalYBal1 = TotalZBal1 = 0;
+    BodyRotOffsetX = BodyRotOffsetY = BodyRotOffsetZ = 0;
+#endif
+#ifdef REF_LEGIK
+    // Random feet of every leg, in and out of reach, as far as the hyp2 of
+    // both ArcTan2 in LegIK holds them
+    InitLegIKConst();
+    while (nLegIK < REFCALLS) {
+        short x = RefRand(-320, 320), y = RefRand(-320, 320), z = RefRand(-320, 320);
+        byte bLeg = RefRand(0, 5);
+        if (((long)x * x + (long)z * z > 320L * 320) || ((long)x * x + (long)y * y + (long)z * z > 320L * 320)
+                || (!x && !z) || (!y && (RefGetATan2(x, z).hyp2 / c2DEC == LegIKConst[bLeg].CoxaLength)))
+            continue;
+        LEGIKSOLUTION sol = LegIK(x, y, z, bLeg), solRef = RefLegIK(x, y, z, bLeg);
+        if ((sol.CoxaAngle1 != solRef.CoxaAngle1) || (sol.FemurAngle1 != solRef.FemurAngle1)
+                || (sol.TibiaAngle1 != solRef.TibiaAngle1) || (sol.bStatus != solRef.bStatus))
+            cLegIK++;
+#ifdef c4DOF
+        else if (LegIKConst[bLeg].TarsLength && (sol.TarsAngle1 != solRef.TarsAngle1))
+            cLegIK++;
+#endif
+        nLegIK++;
+    }
+#endif
+    RefResult("GetSinCos  (every short)", cSinCos, nSinCos, nSinCos);
+    RefResult("GetArcCos  (every short)", cArcCos, nArcCos, nArcCos);
+    RefResult("GetATan2   (r <= 327)", cATan2, nATan2, nATan2);
+    RefResult("BodyFK     (random)", cBodyFK, nBodyFK, nBodyFK);
+    RefResult("LegIK      (random, all legs)", cLegIK, nLegIK, nLegIK);
+    if (cSinCos || cArcCos || cATan2 || cBodyFK || cLegIK) {
+        printf("the math differs from the original\n");
+        return 1;
+    }
+    return 0;
+}
+
+static int MathSweep(void)
+{
+#ifdef OPT_CORDIC_ATAN2
+    printf("CORDIC (%d iterations)", cCORDIC_ITERATIONS);
+#else
+    printf("isqrt32 + ArcCos table");
+#endif
+    printf(" vs libm, errors in the units returned (atan4/acos4 1e-4 rad, hyp2 0.01)\n");
+    printf("%-34s %10s %10s %10s\n", "", "max err", "mean err", "points");
+
+    // Every integer point the hyp2 short can hold (within 327 mm), except the origin
+    ERRSTAT eAtan = {0, 0, 0}, eHyp = {0, 0, 0};
+    for (int x = -327; x <= 327; x++) {
+        for (int y = -327; y <= 327; y++) {
+            if ((!x && !y) || (x * x + y * y > 327 * 327))
+                continue;
+            ATAN2 at = GetATan2(x, y);
+            AddErr(&eAtan, at.atan4 - atan2((double)y, (double)x) * 1e4);
+            AddErr(&eHyp, at.hyp2 - hypot(x, y) * 100);
+        }
+    }
+    printf("%-34s %10.2f %10.3f %10ld\n", "GetATan2 .atan4  (r <= 327)", eAtan.dMax, eAtan.dSum / eAtan.c, eAtan.c);
+    printf("%-34s %10.2f %10.3f %10ld\n", "GetATan2 .hyp2   (r <= 327)", eHyp.dMax, eHyp.dSum / eHyp.c, eHyp.c);
+
+    ERRSTAT eAcos = {0, 0, 0};
+    for (int c = -c4DEC; c <= c4DEC; c++)
+        AddErr(&eAcos, GetArcCos(c) - acos(c / 1e4) * 1e4);
+    printf("%-34s %10.2f %10.3f %10ld\n", "GetArcCos        (-1..1 by 1e-4)", eAcos.dMax, eAcos.dSum / eAcos.c, eAcos.c);
+
+    ERRSTAT eSin = {0, 0, 0};
+    for (int a = -3600; a <= 3600; a++) {
+        SINCOS sc = GetSinCos(a);
+        AddErr(&eSin, (double)sc.sin4 * c4DEC / cSINCOS_ONE - sin(a * M_PI / 1800) * 1e4);
+        AddErr(&eSin, (double)sc.cos4 * c4DEC / cSINCOS_ONE - cos(a * M_PI / 1800) * 1e4);
+    }
+    printf("%-34s %10.2f %10.3f %10ld\n", "GetSinCos, 1e-4  (-360..360 deg)", eSin.dMax, eSin.dSum / eSin.c, eSin.c);
+
+    // Hex_Trig.h at the steps of the sketch's tables has to give what they do:
+    // the same ArcCos and, as it rounds where the sin table was cut off, sin
+    // within a count.
+    int iRet = 0;
+#if !defined(OPT_TRIGTABLES) && !defined(OPT_CORDIC_ATAN2)
+    typedef TRIGSIN<5, cSINCOS_ONE, false> SINDEF;
+    typedef TRIGACOS<79, 8, 2, 8, false> ACOSDEF;
+    int cSinDiff = 0, cAcosDiff = 0;
+    for (int a = 0; a <= 900; a++) {
+        long l = SINDEF::Lookup<TRIGGEN<SINDEF> >(a) - GetSinCos(a).sin4;
+        if (l)
+            cSinDiff++;
+        if (l < -1 || l > 1)
+            iRet = 1;
+    }
+    for (int c = 0; c <= c4DEC; c++) {
+        if (ACOSDEF::Lookup<TRIGGEN<ACOSDEF> >(c) != GetArcCos(c))
+            cAcosDiff++;
+    }
+    printf("%-34s %10d of 901 (ArcCos %d of 10001)\n", "Hex_Trig.h vs the tables, sin", cSinDiff, cAcosDiff);
+    if (cAcosDiff)
+        iRet = 1;
+    if (iRet)
+        printf("Hex_Trig.h does not build the sketch's tables\n");
+#endif
+
+    // Time per call over the grid points LegIK sees (feet within 300 mm)
+    static short as[2 * MATHTIMECALLS];
+    unsigned long ulRand = 1;
+    for (int i = 0; i < 2 * MATHTIMECALLS; i++) {
+        ulRand = ulRand * 1103515245UL + 12345UL;
+        as[i] = (short)((ulRand >> 8) % 601) - 300;
+        if (!as[i])
+            as[i] = 1;
+    }
+    double ns = RealNanos();
+    for (int iPass = 0; iPass < 16; iPass++)
+        for (int i = 0; i < MATHTIMECALLS; i++)
+            s_lMathSink += GetATan2(as[2 * i], as[2 * i + 1]).atan4;
+    double nsAtan = (RealNanos() - ns) / (16.0 * MATHTIMECALLS);
+    ns = RealNanos();
+    for (int iPass = 0; iPass < 16; iPass++)
+        for (int i = 0; i < 2 * MATHTIMECALLS; i++)
+            s_lMathSink += GetArcCos(as[i] * 33);
+    double nsAcos = (RealNanos() - ns) / (32.0 * MATHTIMECALLS);
+    printf("\nhost time per call: GetATan2 %.1f ns, GetArcCos %.1f ns\n", nsAtan, nsAcos);
+
+    // LegIK of the right rear leg with the feet straight out along X (so the
+    // XZ distance is exact), on every mm of its workspace.  Split in the part
+    // OPT_IKTABLE looks up in Hex_IKTable.h and the part LegIK always solves.
+#ifdef OPT_IKTABLE
+    printf("\nLegIK with the workspace table (%d mm grid) vs libm, errors in 0.1 deg\n", 1 << cIKTAB_STEPSHIFT);
+#else
+    printf("\nLegIK vs libm, errors in 0.1 deg\n");
+#endif
+    InitLegIKConst();
+    const double F = cRRFemurLength, T = cRRTibiaLength;
+    const int nReach = cRRFemurLength + cRRTibiaLength;
+    ERRSTAT aeFemur[2] = {{0, 0, 0}, {0, 0, 0}}, aeTibia[2] = {{0, 0, 0}, {0, 0, 0}};
+    long cStatusDiff = 0;
+    for (int d = 0; d <= nReach; d++) {
+        for (int y = -nReach / 3; y <= nReach; y++) {
+            double r = hypot(d, y);
+            if ((r < fabs(F - T) + 1) || (r > nReach))
+                continue;
+            LEGIKSOLUTION sol = LegIK(d + cRRCoxaLength, y, 0, 0);
+            double dFemur1 = 900 - (atan2(d, y) + acos((F * F - T * T + r * r) / (2 * F * r))) * 1800 / M_PI
+                             + LegIKConst[0].FemurHornOffset1;
+            double dTibia1 = -(900 - acos(max(-1.0, (F * F + T * T - r * r) / (2 * F * T))) * 1800 / M_PI);
+            long lHyp2 = (long)floor(r * 100);
+            bool fTable = (d >= cIKTAB_DMIN) && (d < cIKTAB_DMIN + ((cIKTAB_ND - 1) << cIKTAB_STEPSHIFT))
+                          && (y >= cIKTAB_YMIN) && (y < cIKTAB_YMIN + ((cIKTAB_NY - 1) << cIKTAB_STEPSHIFT))
+                          && (d * d + y * y >= cIKTAB_MINR2) && (lHyp2 < LegIKConst[0].ReachOK2);
+            AddErr(&aeFemur[fTable], sol.FemurAngle1 - dFemur1);
+            AddErr(&aeTibia[fTable], sol.TibiaAngle1 - dTibia1);
+            byte bStatus = (lHyp2 < LegIKConst[0].ReachOK2) ? cIKSolution
+                           : (lHyp2 < LegIKConst[0].Reach2) ? cIKSolutionWarning : cIKSolutionError;
+            if (sol.bStatus != bStatus)
+                cStatusDiff++;
+        }
+    }
+    printf("%-34s %10.2f %10.3f %10ld\n", "femur  (table area)", aeFemur[1].dMax, aeFemur[1].dSum / aeFemur[1].c, aeFemur[1].c);
+    printf("%-34s %10.2f %10.3f %10ld\n", "tibia  (table area)", aeTibia[1].dMax, aeTibia[1].dSum / aeTibia[1].c, aeTibia[1].c);
+    printf("%-34s %10.2f %10.3f %10ld\n", "femur  (rest of the workspace)", aeFemur[0].dMax, aeFemur[0].dSum / aeFemur[0].c, aeFemur[0].c);
+    printf("%-34s %10.2f %10.3f %10ld\n", "tibia  (rest of the workspace)", aeTibia[0].dMax, aeTibia[0].dSum / aeTibia[0].c, aeTibia[0].c);
+    printf("%-34s %10ld\n", "status differences", cStatusDiff);
+
+    // Time per call on feet positions around the standing pose
+    ns = RealNanos();
+    for (int iPass = 0; iPass < 4; iPass++)
+        for (int i = 0; i < MATHTIMECALLS; i++)
+            s_lMathSink += LegIK(cRRCoxaLength + 60 + as[2 * i] / 8, 50 + as[2 * i + 1] / 8, as[2 * i] / 4, 0).FemurAngle1;
+    printf("host time per call: LegIK %.1f ns\n", (RealNanos() - ns) / (4.0 * MATHTIMECALLS));
+
+    // BodyFK of the right rear leg with the body tilted up to 30 deg each way
+    // and turned all the way around, on angles the sin table has exactly
+#ifdef OPT_FIXEDPOINT
+    printf("\nBodyFK in fixed point vs the decimal math and libm, errors in mm\n");
+#else
+    printf("\nBodyFK in decimals vs the decimal math and libm, errors in mm\n");
+#endif
+    ERRSTAT eDrift = {0, 0, 0}, eReal = {0, 0, 0}, eDecReal = {0, 0, 0};
+    BODYROT Rot;
+    memset(&Rot, 0, sizeof(Rot));
+    Rot.RotX1 = Rot.RotZ1 = Rot.LegRotY1 = -1;      // nothing looked up yet
+    for (int G1 = -300; G1 <= 300; G1 += 50) {
+        for (int B1 = -300; B1 <= 300; B1 += 50) {
+            for (int A1 = -1800; A1 <= 1800; A1 += 150) {
+                BodyRotUpdate(&Rot, G1, A1, B1);
+                for (int x = -250; x <= 250; x += 50) {
+                    for (int z = -250; z <= 250; z += 50) {
+                        for (int y = -150; y <= 150; y += 50) {
+                            COORD3D Pos = BodyFK(&Rot, x - cRROffsetX, z - cRROffsetZ, y, 0, cRR);
+                            COORD3D Dec = DecBodyFK(x, y, z, A1, B1, G1);
+                            double ad[3];
+                            RealBodyFK(ad, x, y, z, A1, B1, G1);
+                            AddErr(&eDrift, max(max(abs(Pos.x - Dec.x), abs(Pos.y - Dec.y)), abs(Pos.z - Dec.z)));
+                            AddErr(&eReal, max(max(fabs(Pos.x - ad[0]), fabs(Pos.y - ad[1])), fabs(Pos.z - ad[2])));
+                            AddErr(&eDecReal, max(max(fabs(Dec.x - ad[0]), fabs(Dec.y - ad[1])), fabs(Dec.z - ad[2])));
+                        }
+                    }
+                }
+            }
+        }
+    }
+    printf("%-34s %10.2f %10.3f %10ld\n", "BodyFK vs decimal math", eDrift.dMax, eDrift.dSum / eDrift.c, eDrift.c);
+    printf("%-34s %10.2f %10.3f %10ld\n", "BodyFK vs libm", eReal.dMax, eReal.dSum / eReal.c, eReal.c);
+    printf("%-34s %10.2f %10.3f %10ld\n", "decimal math vs libm", eDecReal.dMax, eDecReal.dSum / eDecReal.c, eDecReal.c);
+#if defined(OPT_FIXEDPOINT) && defined(QNUM_CHECK)
+    printf("%-34s %10lu\n", "fixed point overflows", g_cQNumOverflows);
+    if (g_cQNumOverflows)
+        iRet = 1;
+#endif
+    if (eDrift.dMax > cFKMAXDRIFT) {
+        printf("BodyFK drifts more than %d mm from the decimal math\n", cFKMAXDRIFT);
+        iRet = 1;
+    }
+
+    BodyRotUpdate(&Rot, 100, 50, -150);
+    ns = RealNanos();
+    for (int iPass = 0; iPass < 4; iPass++)
+        for (int i = 0; i < MATHTIMECALLS; i++)
+            s_lMathSink += BodyFK(&Rot, as[2 * i] / 2, as[2 * i + 1] / 2, as[2 * i] / 4, 0, cRR).x;
+    printf("host time per call: BodyFK %.1f ns\n", (RealNanos() - ns) / (4.0 * MATHTIMECALLS));
+
+    if (RefSweep())
+        iRet = 1;
+    return iRet;
+}
+
+static void EchoDebug(const uint8_t *pb, size_t cb)
+{
+    fwrite(pb, 1, cb, stdout);
+}
+
+int main(int argc, char **argv)
+{
+    bool fDeterministic = false;
+    bool fNoWireTime = false;
+    bool fVerbose = false;
+    bool fMath = false;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-d"))
+            fDeterministic = true;
+        else if (!strcmp(argv[i], "-n"))
+            fNoWireTime = true;
+        else if (!strcmp(argv[i], "-v"))
+            fVerbose = true;
+        else if (!strcmp(argv[i], "-m"))
+            fMath = true;
+        else {
+            fprintf(stderr, "usage: %s [-d] [-n] [-v] [-m]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    if (fMath)
+        return MathSweep();
+
+    HostSetDeterministic(fDeterministic);
+    if (fVerbose)
+        Serial.hostSetTxHook(EchoDebug);
+    SSC32SimAttach();
+    InitStageFns();
+
+    setup();
+    if (fNoWireTime)
+        Serial1.hostSetNoWireTime();
+
+    printf("Hexapod_Apod host benchmark (%s clock, SSC-32 at %d baud%s)\n",
+           fDeterministic ? "deterministic" : "host", cSSC_BAUD, fNoWireTime ? " without wire time" : "");
+    PrintHeader();
+
+    SCENARIO total, walk;
+    memset(&total, 0, sizeof(total));
+    memset(&walk, 0, sizeof(walk));
+    unsigned long long ansTotalStage[NUM_STAGES] = {0};
+    unsigned long long nsTotalStageDelay = 0;
+
+    for (size_t iStep = 0; iStep < sizeof(s_aScript) / sizeof(s_aScript[0]); iStep++) {
+        const BENCHSTEP *pStep = &s_aScript[iStep];
+        SCENARIO sc;
+        memset(&sc, 0, sizeof(sc));
+        memset(s_ansStage, 0, sizeof(s_ansStage));
+        s_nsStageDelay = 0;
+        unsigned long cbSSCStart = Serial1.hostTxBytes();
+        unsigned long cMovesStart = SSC32SimStats()->cGroupMoves;
+        unsigned long long nsDelayStart = HostDelayNanos();
+        unsigned long long nsTxBlockStart = HostTxBlockNanos();
+
+        for (int iCycle = 0; iCycle < pStep->cCycles; iCycle++) {
+            uint16_t wButtons = pStep->wHold | (iCycle ? 0 : pStep->wPress);
+            PS2XStubSetState(wButtons, pStep->bLX, pStep->bLY, pStep->bRX, pStep->bRY);
+
+            unsigned long long nsStart = HostNanos();
+            loop();
+            unsigned long long ns = HostNanos() - nsStart;
+            sc.nsTotal += ns;
+            if (ns > sc.nsMax)
+                sc.nsMax = ns;
+            sc.cCycles++;
+        }
+        sc.cbSSC = Serial1.hostTxBytes() - cbSSCStart;
+        sc.cGroupMoves = SSC32SimStats()->cGroupMoves - cMovesStart;
+        sc.nsDelay = HostDelayNanos() - nsDelayStart;
+        sc.nsTxBlock = HostTxBlockNanos() - nsTxBlockStart;
+
+        if (pStep->pszName)
+            PrintScenario(pStep->pszName, &sc);
+
+        total.cCycles += sc.cCycles;
+        total.nsTotal += sc.nsTotal;
+        total.nsMax = max(total.nsMax, sc.nsMax);
+        total.nsDelay += sc.nsDelay;
+        total.nsTxBlock += sc.nsTxBlock;
+        total.cbSSC += sc.cbSSC;
+        total.cGroupMoves += sc.cGroupMoves;
+        if (pStep->pszName && !strncmp(pStep->pszName, "walk", 4)) {
+            walk.nsTotal += sc.nsTotal;
+            walk.cbSSC += sc.cbSSC;
+            walk.cGroupMoves += sc.cGroupMoves;
+        }
+        for (int i = 0; i < NUM_STAGES; i++)
+            ansTotalStage[i] += s_ansStage[i];
+        nsTotalStageDelay += s_nsStageDelay;
+    }
+
+    memcpy(s_ansStage, ansTotalStage, sizeof(s_ansStage));
+    s_nsStageDelay = nsTotalStageDelay;
+    PrintScenario("TOTAL", &total);
+
+    const SSC32SIMSTATS *pStats = SSC32SimStats();
+    printf("\nSSC-32: %lu bytes, %lu group moves, %lu servo commands, %.1f ms TX backpressure, digest %08x\n",
+           pStats->cbRx, pStats->cGroupMoves, pStats->cServoCmds, total.nsTxBlock / 1e6,
+           (unsigned)pStats->ulDigest);
+    // How many walking frames a second the link could take at their size
+    if (Serial1.hostNsPerByte() && walk.cGroupMoves && walk.nsTotal) {
+        double dLinkBps = 1e9 / Serial1.hostNsPerByte();
+        double dFrameBytes = (double)walk.cbSSC / walk.cGroupMoves;
+        double dSeconds = walk.nsTotal / 1e9;
+        printf("Link: %.0f B/s; walking %.1f frames/s of %.1f B, %.0f%% of the link; it takes %.1f frames/s (%.1f ms)\n",
+               dLinkBps, walk.cGroupMoves / dSeconds, dFrameBytes, 100.0 * walk.cbSSC / dSeconds / dLinkBps,
+               dLinkBps / dFrameBytes, 1000.0 * dFrameBytes / dLinkBps);
+    }
+#ifdef OPT_IK_CACHE
+    printf("IK cache: %lu of %lu legs kept their angles (%.0f%%)\n", g_cIKCacheHits, g_cIKCacheLegs,
+           g_cIKCacheLegs ? 100.0 * g_cIKCacheHits / g_cIKCacheLegs : 0.0);
+#endif
+#ifdef OPT_IDLE
+    printf("Idle: %lu of %lu cycles only read the input, %lu wakes\n", g_cIdleCycles, total.cCycles, g_cIdleWakes);
+#endif
+#ifdef OPT_SSC_DELTAUPDATES
+    printf("Delta updates: %lu frames sent, %lu servos skipped, %lu bytes saved\n",
+           g_ServoDriver.CFramesSent(), g_ServoDriver.CServosSkipped(), g_ServoDriver.CbSaved());
+#endif
+#ifdef OPT_PROFILE
+    static const char *s_apszProfStages[NUM_PROFSTAGES] = {
+        "Voltage", "Input", "GPPlayer", "SingleLeg", "GaitSeq", "Balance", "FK/IK", "Angles", "Servos", "Commit",
+        "MoveWait", "MoveSaved"};
+    printf("Sketch profile (us):   calls   min     avg     max\n");
+    for (int iStage = 0; iStage < NUM_PROFSTAGES; iStage++) {
+        const PROFSTAGE *pStage = &g_aProfStages[iStage];
+        printf("  %-18s %7u %5u %7lu %7u\n", s_apszProfStages[iStage], pStage->cCalls, pStage->wMin,
+               pStage->cCalls ? pStage->ulSum / pStage->cCalls : 0UL, pStage->wMax);
+    }
+#endif
+#ifdef OPT_SCHEDULER
+    printf("Scheduler: %lu cycles, %lu missed, max %lu us late; late(us)",
+           g_SchedStats.cCycles, g_SchedStats.cMissed, g_SchedStats.ulMaxLate);
+    for (int iBucket = 0; iBucket < cSCHED_LATEBUCKETS - 1; iBucket++)
+        printf(" <%lu:%u", 64UL << iBucket, g_SchedStats.awLate[iBucket]);
+    printf(" >=%lu:%u\n", 64UL << (cSCHED_LATEBUCKETS - 2), g_SchedStats.awLate[cSCHED_LATEBUCKETS - 1]);
+#endif
+    return 0;
+}
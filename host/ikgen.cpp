@@ -0,0 +1,95 @@
+//==============================================================================
+// ikgen.cpp - Generates Hex_IKTable.h, the leg workspace table for OPT_IKTABLE.
+//
+// For the femur and tibia lengths in Hex_Cfg.h it solves the femur and tibia
+// angles in floating point on a grid over the (XZ distance from the femur
+// axis, Y) plane the leg can reach.  LegIK interpolates between the grid
+// points instead of solving the angles itself.
+//
+//   ikgen [step] > ../Hex_IKTable.h
+//     step     grid step in mm: 4, 8 (default) or 16
+//==============================================================================
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "Hex_Cfg.h"
+
+static double Clamp1(double d)
+{
+    return (d < -1.0) ? -1.0 : (d > 1.0) ? 1.0 : d;
+}
+
+int main(int argc, char **argv)
+{
+    int nStep = (argc > 1) ? atoi(argv[1]) : 8;
+    int nShift;
+
+    switch (nStep) {
+    case 4:     nShift = 2; break;
+    case 8:     nShift = 3; break;
+    case 16:    nShift = 4; break;
+    default:
+        fprintf(stderr, "usage: %s [4|8|16]\n", argv[0]);
+        return 2;
+    }
+
+    // The sketch checks that every leg has these lengths
+    const double F = cRRFemurLength;
+    const double T = cRRTibiaLength;
+    const int nReach = cRRFemurLength + cRRTibiaLength;
+
+    // XZ from the femur axis out to full reach, Y from a third of the reach
+    // above the femur axis to full reach below it
+    int nDMin = 0;
+    int cD = (nReach + nStep - 1) / nStep + 1;
+    int nYMin = -((nReach / 3) / nStep) * nStep;
+    int cY = (nReach - nYMin + nStep - 1) / nStep + 1;
+
+    // Closer to the femur axis than |femur - tibia| the leg cannot fold and
+    // the angles change fastest; LegIK solves these itself.  Keep all four
+    // grid points around a looked up position outside of that radius.
+    double dMinR = fabs(F - T) + nStep * 1.5;
+
+    printf("//==============================================================================\n");
+    printf("// Hex_IKTable.h - Femur and tibia angles over the leg workspace (OPT_IKTABLE).\n");
+    printf("//\n");
+    printf("// Generated by host/ikgen for femur %d mm, tibia %d mm and a %d mm grid,\n",
+           cRRFemurLength, cRRTibiaLength, nStep);
+    printf("// %d x %d points, %d bytes.  Do not edit, run \"make -C host iktable\".\n",
+           cD, cY, cD * cY * 4);
+    printf("//==============================================================================\n");
+    printf("#define cIKTAB_FEMUR        %d\n", cRRFemurLength);
+    printf("#define cIKTAB_TIBIA        %d\n", cRRTibiaLength);
+    printf("#define cIKTAB_STEPSHIFT    %d           // grid step %d mm\n", nShift, nStep);
+    printf("#define cIKTAB_DMIN         %d\n", nDMin);
+    printf("#define cIKTAB_ND           %d\n", cD);
+    printf("#define cIKTAB_YMIN         %d\n", nYMin);
+    printf("#define cIKTAB_NY           %d\n", cY);
+    printf("#define cIKTAB_MINR2        %ldL      // (|femur - tibia| + 1.5 steps)^2, mm\n",
+           (long)ceil(dMinR * dMinR));
+    printf("\n");
+    printf("//{900 - femur, tibia} in degrees, decimals = 1, without horn offsets; by Y then XZ\n");
+    printf("static const short GetIKTable[cIKTAB_NY*cIKTAB_ND][2] PROGMEM = {\n");
+    for (int iY = 0; iY < cY; iY++) {
+        double y = nYMin + iY * nStep;
+        printf("   ");
+        for (int iD = 0; iD < cD; iD++) {
+            double d = nDMin + iD * nStep;
+            double r = hypot(d, y);
+            if (r < 1.0)
+                r = 1.0;
+
+            // Same solution as LegIK: IKA14 = angle of the S>W line, IKA24 =
+            // angle of the femur to it, both by the law of cosines
+            double dA14 = atan2(d, y);
+            double dA24 = acos(Clamp1((F * F - T * T + r * r) / (2 * F * r)));
+            double dTibia = acos(Clamp1((F * F + T * T - r * r) / (2 * F * T)));
+            long lFemur1 = lround((dA14 + dA24) * 1800.0 / M_PI);
+            long lTibia1 = lround(-(900.0 - dTibia * 1800.0 / M_PI));
+            printf(" {%ld,%ld}%s", lFemur1, lTibia1, ((iY == cY - 1) && (iD == cD - 1)) ? "" : ",");
+        }
+        printf("\n");
+    }
+    printf("};\n");
+    return 0;
+}
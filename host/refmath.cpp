@@ -0,0 +1,474 @@
+//==============================================================================
+// refmath.cpp - The sketch math the way it was before it returned its results,
+// see refmath.h.
+//
+// The functions in OldMath are the original ones unchanged; the Ref*
+// wrappers clear their globals and return what they left there.
+//==============================================================================
+#include <string.h>
+#include "Arduino.h"
+#include "refmath.h"
+
+extern short    BodyRotOffsetX;
+extern short    BodyRotOffsetY;
+extern short    BodyRotOffsetZ;
+extern long     TotalXBal1;
+extern long     TotalYBal1;
+extern long     TotalZBal1;
+
+namespace OldMath {
+
+//=============================================================================
+// Tables (the sketch's are static)
+//=============================================================================
+static const byte GetACos[] PROGMEM = {    
+                    255,254,252,251,250,249,247,246,245,243,242,241,240,238,237,236,234,233,232,231,229,228,227,225, 
+                    224,223,221,220,219,217,216,215,214,212,211,210,208,207,206,204,203,201,200,199,197,196,195,193, 
+                    192,190,189,188,186,185,183,182,181,179,178,176,175,173,172,170,169,167,166,164,163,161,160,158, 
+                    157,155,154,152,150,149,147,146,144,142,141,139,137,135,134,132,130,128,127,125,123,121,119,117, 
+                    115,113,111,109,107,105,103,101,98,96,94,92,89,87,84,81,79,76,73,73,73,72,72,72,71,71,71,70,70, 
+                    70,70,69,69,69,68,68,68,67,67,67,66,66,66,65,65,65,64,64,64,63,63,63,62,62,62,61,61,61,60,60,59,
+                    59,59,58,58,58,57,57,57,56,56,55,55,55,54,54,53,53,53,52,52,51,51,51,50,50,49,49,48,48,47,47,47,
+                    46,46,45,45,44,44,43,43,42,42,41,41,40,40,39,39,38,37,37,36,36,35,34,34,33,33,32,31,31,30,29,28,
+                    28,27,26,25,24,23,23,23,23,22,22,22,22,21,21,21,21,20,20,20,19,19,19,19,18,18,18,17,17,17,17,16,
+                    16,16,15,15,15,14,14,13,13,13,12,12,11,11,10,10,9,9,8,7,6,6,5,3,0 };//
+
+static const word GetSin[] PROGMEM = {0, 87, 174, 261, 348, 436, 523, 610, 697, 784, 871, 958, 1045, 1132, 1218, 1305, 1391, 1478, 1564, 
+                 1650, 1736, 1822, 1908, 1993, 2079, 2164, 2249, 2334, 2419, 2503, 2588, 2672, 2756, 2840, 2923, 3007, 
+                 3090, 3173, 3255, 3338, 3420, 3502, 3583, 3665, 3746, 3826, 3907, 3987, 4067, 4146, 4226, 4305, 4383, 
+                 4461, 4539, 4617, 4694, 4771, 4848, 4924, 4999, 5075, 5150, 5224, 5299, 5372, 5446, 5519, 5591, 5664, 
+                 5735, 5807, 5877, 5948, 6018, 6087, 6156, 6225, 6293, 6360, 6427, 6494, 6560, 6626, 6691, 6755, 6819, 
+                 6883, 6946, 7009, 7071, 7132, 7193, 7253, 7313, 7372, 7431, 7489, 7547, 7604, 7660, 7716, 7771, 7826, 
+                 7880, 7933, 7986, 8038, 8090, 8141, 8191, 8241, 8290, 8338, 8386, 8433, 8480, 8526, 8571, 8616, 8660, 
+                 8703, 8746, 8788, 8829, 8870, 8910, 8949, 8987, 9025, 9063, 9099, 9135, 9170, 9205, 9238, 9271, 9304, 
+                 9335, 9366, 9396, 9426, 9455, 9483, 9510, 9537, 9563, 9588, 9612, 9636, 9659, 9681, 9702, 9723, 9743, 
+                 9762, 9781, 9799, 9816, 9832, 9848, 9862, 9876, 9890, 9902, 9914, 9925, 9935, 9945, 9953, 9961, 9969, 
+                 9975, 9981, 9986, 9990, 9993, 9996, 9998, 9999, 10000 };//
+
+const byte cCoxaLength[] PROGMEM = {cRRCoxaLength,  cRMCoxaLength,  cRFCoxaLength,  cLRCoxaLength,  cLMCoxaLength,  cLFCoxaLength};
+const byte cFemurLength[] PROGMEM = {cRRFemurLength, cRMFemurLength, cRFFemurLength, cLRFemurLength, cLMFemurLength, cLFFemurLength};
+const byte cTibiaLength[] PROGMEM = {cRRTibiaLength, cRMTibiaLength, cRFTibiaLength, cLRTibiaLength, cLMTibiaLength, cLFTibiaLength};
+#ifdef c4DOF
+const byte cTarsLength[] PROGMEM = {cRRTarsLength, cRMTarsLength, cRFTarsLength, cLRTarsLength, cLMTarsLength, cLFTarsLength};
+#endif
+const short cOffsetX[] PROGMEM = {cRROffsetX, cRMOffsetX, cRFOffsetX, cLROffsetX, cLMOffsetX, cLFOffsetX};
+const short cOffsetZ[] PROGMEM = {cRROffsetZ, cRMOffsetZ, cRFOffsetZ, cLROffsetZ, cLMOffsetZ, cLFOffsetZ};
+const short cCoxaAngle1[] PROGMEM = {cRRCoxaAngle1, cRMCoxaAngle1, cRFCoxaAngle1, cLRCoxaAngle1, cLMCoxaAngle1, cLFCoxaAngle1};
+
+#ifdef cRRFemurHornOffset1
+const short cFemurHornOffset1[] PROGMEM = {cRRFemurHornOffset1,  cRMFemurHornOffset1,  cRFFemurHornOffset1,  cLRFemurHornOffset1,  cLMFemurHornOffset1,  cLFFemurHornOffset1};
+#define CFEMURHORNOFFSET1(LEGI) ((short)pgm_read_word(&cFemurHornOffset1[LEGI]))
+#else
+#ifndef cFemurHornOffset1
+#define cFemurHornOffset1  0
+#endif
+#define CFEMURHORNOFFSET1(LEGI)  (cFemurHornOffset1)
+#endif
+
+#ifdef c4DOF
+#ifdef cRRTarsHornOffset1
+const short cTarsHornOffset1[] PROGMEM = {cRRTarsHornOffset1,  cRMTarsHornOffset1,  cRFTarsHornOffset1,  cLRTarsHornOffset1,  cLMTarsHornOffset1,  cLFTarsHornOffset1};
+#define CTARSHORNOFFSET1(LEGI) ((short)pgm_read_word(&cTarsHornOffset1[LEGI]))
+#else
+#ifndef cTarsHornOffset1
+#define cTarsHornOffset1  0
+#endif
+#define CTARSHORNOFFSET1(LEGI)  cTarsHornOffset1
+#endif
+#endif
+
+//=============================================================================
+// Globals the functions leave their results in
+//=============================================================================
+short           sin4;             //Output Sinus of the given Angle, decimals = 4
+short           cos4;            //Output Cosinus of the given Angle, decimals = 4
+short           AngleRad4;        //Output Angle in radials, decimals = 4
+short           Atan4;            //ArcTan2 output
+short           XYhyp2;            //Output presenting Hypotenuse of X and Y
+long            BodyFKPosX;        //Output Position X of feet with Rotation
+long            BodyFKPosY;        //Output Position Y of feet with Rotation
+long            BodyFKPosZ;        //Output Position Z of feet with Rotation
+short           CoxaAngle1[6];    //Actual Angle of the horizontal hip, decimals = 1
+short           FemurAngle1[6];   //Actual Angle of the vertical hip, decimals = 1
+short           TibiaAngle1[6];   //Actual Angle of the knee, decimals = 1
+#ifdef c4DOF
+short           TarsAngle1[6];	  //Actual Angle of the knee, decimals = 1
+#endif
+boolean         IKSolution;        //Output true if the solution is possible
+boolean         IKSolutionWarning;    //Output true if the solution is NEARLY possible
+boolean         IKSolutionError;    //Output true if the solution is NOT possible
+
+//=============================================================================
+// The original functions
+//=============================================================================
+#pragma GCC diagnostic ignored "-Wsign-compare"     // left as they were
+
+//--------------------------------------------------------------------
+//[GETSINCOS] Get the sinus and cosinus from the angle +/- multiple circles
+//AngleDeg1     - Input Angle in degrees
+//sin4        - Output Sinus of AngleDeg
+//cos4          - Output Cosinus of AngleDeg
+void GetSinCos(short AngleDeg1)
+{
+    short        ABSAngleDeg1;    //Absolute value of the Angle in Degrees, decimals = 1
+    //Get the absolute value of AngleDeg
+    if (AngleDeg1 < 0)
+        ABSAngleDeg1 = AngleDeg1 *-1;
+    else
+          ABSAngleDeg1 = AngleDeg1;
+    
+    //Shift rotation to a full circle of 360 deg -> AngleDeg // 360
+    if (AngleDeg1 < 0)    //Negative values
+        AngleDeg1 = 3600-(ABSAngleDeg1-(3600*(ABSAngleDeg1/3600)));
+    else                //Positive values
+        AngleDeg1 = ABSAngleDeg1-(3600*(ABSAngleDeg1/3600));
+    
+    if (AngleDeg1>=0 && AngleDeg1<=900)     // 0 to 90 deg
+    {
+        sin4 = pgm_read_word(&GetSin[AngleDeg1/5]);             // 5 is the presision (0.5) of the table
+        cos4 = pgm_read_word(&GetSin[(900-(AngleDeg1))/5]);
+    }     
+        
+    else if (AngleDeg1>900 && AngleDeg1<=1800)     // 90 to 180 deg
+    {
+        sin4 = pgm_read_word(&GetSin[(900-(AngleDeg1-900))/5]); // 5 is the presision (0.5) of the table    
+        cos4 = -pgm_read_word(&GetSin[(AngleDeg1-900)/5]);            
+    }    
+    else if (AngleDeg1>1800 && AngleDeg1<=2700) // 180 to 270 deg
+    {
+        sin4 = -pgm_read_word(&GetSin[(AngleDeg1-1800)/5]);     // 5 is the presision (0.5) of the table
+        cos4 = -pgm_read_word(&GetSin[(2700-AngleDeg1)/5]);
+    }    
+
+    else if(AngleDeg1>2700 && AngleDeg1<=3600) // 270 to 360 deg
+    {
+        sin4 = -pgm_read_word(&GetSin[(3600-AngleDeg1)/5]); // 5 is the presision (0.5) of the table    
+        cos4 = pgm_read_word(&GetSin[(AngleDeg1-2700)/5]);            
+    }
+}    
+
+//--------------------------------------------------------------------
+//(GETARCCOS) Get the sinus and cosinus from the angle +/- multiple circles
+//cos4        - Input Cosinus
+//AngleRad4     - Output Angle in AngleRad4
+long GetArcCos(short cos4)
+{
+    boolean NegativeValue/*:1*/;    //If the the value is Negative
+    //Check for negative value
+    if (cos4<0)
+    {
+        cos4 = -cos4;
+        NegativeValue = 1;
+    }
+    else
+        NegativeValue = 0;
+    
+    //Limit cos4 to his maximal value
+    cos4 = min(cos4,c4DEC);
+    
+    if ((cos4>=0) && (cos4<9000))
+    {
+        AngleRad4 = (byte)pgm_read_byte(&GetACos[cos4/79]);
+        AngleRad4 = ((long)AngleRad4*616)/c1DEC;            //616=acos resolution (pi/2/255) ;
+    }    
+    else if ((cos4>=9000) && (cos4<9900))
+    {
+        AngleRad4 = (byte)pgm_read_byte(&GetACos[(cos4-9000)/8+114]);
+        AngleRad4 = (long)((long)AngleRad4*616)/c1DEC;             //616=acos resolution (pi/2/255) 
+    }
+    else if ((cos4>=9900) && (cos4<=10000))
+    {
+        AngleRad4 = (byte)pgm_read_byte(&GetACos[(cos4-9900)/2+227]);
+        AngleRad4 = (long)((long)AngleRad4*616)/c1DEC;             //616=acos resolution (pi/2/255) 
+    }
+       
+    //Add negative sign
+    if (NegativeValue)
+        AngleRad4 = 31416 - AngleRad4;
+
+    return AngleRad4;
+}    
+
+unsigned long isqrt32 (unsigned long n) //
+{
+        unsigned long root;
+        unsigned long remainder;
+        unsigned long  place;
+
+        root = 0;
+        remainder = n;
+        place = 0x40000000; // OR place = 0x4000; OR place = 0x40; - respectively
+
+        while (place > remainder)
+        place = place >> 2;
+        while (place)
+        {
+                if (remainder >= root + place)
+                {
+                        remainder = remainder - root - place;
+                        root = root + (place << 1);
+                }
+                root = root >> 1;
+                place = place >> 2;
+        }
+        return root;
+}
+
+
+//--------------------------------------------------------------------
+//(GETATAN2) Simplyfied ArcTan2 function based on fixed point ArcCos
+//ArcTanX         - Input X
+//ArcTanY         - Input Y
+//ArcTan4          - Output ARCTAN2(X/Y)
+//XYhyp2            - Output presenting Hypotenuse of X and Y
+short GetATan2 (short AtanX, short AtanY)
+{
+    XYhyp2 = isqrt32(((long)AtanX*AtanX*c4DEC) + ((long)AtanY*AtanY*c4DEC));
+    GetArcCos (((long)AtanX*(long)c6DEC) /(long) XYhyp2);
+    
+    if (AtanY < 0)                // removed overhead... Atan4 = AngleRad4 * (AtanY/abs(AtanY));  
+        Atan4 = -AngleRad4;
+    else
+        Atan4 = AngleRad4;
+    return Atan4;
+}    
+    
+//--------------------------------------------------------------------
+//(BODY INVERSE KINEMATICS) 
+//BodyRotX         - Global Input pitch of the body 
+//BodyRotY         - Global Input rotation of the body 
+//BodyRotZ         - Global Input roll of the body 
+//RotationY         - Input Rotation for the gait 
+//PosX            - Input position of the feet X 
+//PosZ            - Input position of the feet Z 
+//SinB                  - Sin buffer for BodyRotX
+//CosB               - Cos buffer for BodyRotX
+//SinG                  - Sin buffer for BodyRotZ
+//CosG               - Cos buffer for BodyRotZ
+//BodyFKPosX         - Output Position X of feet with Rotation 
+//BodyFKPosY         - Output Position Y of feet with Rotation 
+//BodyFKPosZ         - Output Position Z of feet with Rotation
+void BodyFK (short PosX, short PosZ, short PosY, short RotationY, byte BodyIKLeg) 
+{
+    short            SinA4;          //Sin buffer for BodyRotX calculations
+    short            CosA4;          //Cos buffer for BodyRotX calculations
+    short            SinB4;          //Sin buffer for BodyRotX calculations
+    short            CosB4;          //Cos buffer for BodyRotX calculations
+    short            SinG4;          //Sin buffer for BodyRotZ calculations
+    short            CosG4;          //Cos buffer for BodyRotZ calculations
+    short            CPR_X;            //Final X value for centerpoint of rotation
+    short            CPR_Y;            //Final Y value for centerpoint of rotation
+    short            CPR_Z;            //Final Z value for centerpoint of rotation
+
+    //Calculating totals from center of the body to the feet 
+    CPR_X = (short)pgm_read_word(&cOffsetX[BodyIKLeg])+PosX + BodyRotOffsetX;
+    CPR_Y = PosY + BodyRotOffsetY;         //Define centerpoint for rotation along the Y-axis
+    CPR_Z = (short)pgm_read_word(&cOffsetZ[BodyIKLeg]) + PosZ + BodyRotOffsetZ;
+
+    //Successive global rotation matrix: 
+    //Math shorts for rotation: Alfa [A] = Xrotate, Beta [B] = Zrotate, Gamma [G] = Yrotate 
+    //Sinus Alfa = SinA, cosinus Alfa = cosA. and so on... 
+    
+    //First calculate sinus and cosinus for each rotation: 
+    GetSinCos (g_InControlState.BodyRot1.x+TotalXBal1);
+    SinG4 = sin4;
+    CosG4 = cos4;
+    
+    GetSinCos (g_InControlState.BodyRot1.z+TotalZBal1); 
+    SinB4 = sin4;
+    CosB4 = cos4;
+    
+    GetSinCos (g_InControlState.BodyRot1.y+(RotationY*c1DEC)+TotalYBal1) ;
+    SinA4 = sin4;
+    CosA4 = cos4;
+    
+    //Calcualtion of rotation matrix: 
+      BodyFKPosX = ((long)CPR_X*c2DEC - ((long)CPR_X*c2DEC*CosA4/c4DEC*CosB4/c4DEC - (long)CPR_Z*c2DEC*CosB4/c4DEC*SinA4/c4DEC 
+              + (long)CPR_Y*c2DEC*SinB4/c4DEC ))/c2DEC;
+      BodyFKPosZ = ((long)CPR_Z*c2DEC - ( (long)CPR_X*c2DEC*CosG4/c4DEC*SinA4/c4DEC + (long)CPR_X*c2DEC*CosA4/c4DEC*SinB4/c4DEC*SinG4/c4DEC 
+              + (long)CPR_Z*c2DEC*CosA4/c4DEC*CosG4/c4DEC - (long)CPR_Z*c2DEC*SinA4/c4DEC*SinB4/c4DEC*SinG4/c4DEC 
+              - (long)CPR_Y*c2DEC*CosB4/c4DEC*SinG4/c4DEC ))/c2DEC;
+      BodyFKPosY = ((long)CPR_Y  *c2DEC - ( (long)CPR_X*c2DEC*SinA4/c4DEC*SinG4/c4DEC - (long)CPR_X*c2DEC*CosA4/c4DEC*CosG4/c4DEC*SinB4/c4DEC 
+              + (long)CPR_Z*c2DEC*CosA4/c4DEC*SinG4/c4DEC + (long)CPR_Z*c2DEC*CosG4/c4DEC*SinA4/c4DEC*SinB4/c4DEC 
+              + (long)CPR_Y*c2DEC*CosB4/c4DEC*CosG4/c4DEC ))/c2DEC;
+}  
+
+
+
+//--------------------------------------------------------------------
+//[LEG INVERSE KINEMATICS] Calculates the angles of the coxa, femur and tibia for the given position of the feet
+//IKFeetPosX            - Input position of the Feet X
+//IKFeetPosY            - Input position of the Feet Y
+//IKFeetPosZ            - Input Position of the Feet Z
+//IKSolution            - Output true if the solution is possible
+//IKSolutionWarning     - Output true if the solution is NEARLY possible
+//IKSolutionError    - Output true if the solution is NOT possible
+//FemurAngle1           - Output Angle of Femur in degrees
+//TibiaAngle1           - Output Angle of Tibia in degrees
+//CoxaAngle1            - Output Angle of Coxa in degrees
+//--------------------------------------------------------------------
+void LegIK (short IKFeetPosX, short IKFeetPosY, short IKFeetPosZ, byte LegIKLegNr)
+{
+    unsigned long    IKSW2;            //Length between Shoulder and Wrist, decimals = 2
+    unsigned long    IKA14;            //Angle of the line S>W with respect to the ground in radians, decimals = 4
+    unsigned long    IKA24;            //Angle of the line S>W with respect to the femur in radians, decimals = 4
+    short            IKFeetPosXZ;    //Diagonal direction from Input X and Z
+#ifdef c4DOF
+// these were shorts...
+    long            TarsOffsetXZ;    //Vector value \ ;
+    long            TarsOffsetY;     //Vector value / The 2 DOF IK calcs (femur and tibia) are based upon these vectors
+    long            TarsToGroundAngle1;    //Angle between tars and ground. Note: the angle are 0 when the tars are perpendicular to the ground
+    long            TGA_A_H4;
+    long            TGA_B_H3;
+#else
+#define TarsOffsetXZ 0		// Vector value
+#define TarsOffsetY  0		//Vector value / The 2 DOF IK calcs (femur and tibia) are based upon these vectors
+#endif
+
+
+    long            Temp1;            
+    long            Temp2;            
+    long            T3;
+    
+    //Calculate IKCoxaAngle and IKFeetPosXZ
+    GetATan2 (IKFeetPosX, IKFeetPosZ);
+    CoxaAngle1[LegIKLegNr] = (((long)Atan4*180) / 3141) + (short)pgm_read_word(&cCoxaAngle1[LegIKLegNr]);
+    
+    //Length between the Coxa and tars [foot]
+    IKFeetPosXZ = XYhyp2/c2DEC;
+#ifdef c4DOF
+    // Some legs may have the 4th DOF and some may not, so handle this here...
+    //Calc the TarsToGroundAngle1:
+    if ((byte)pgm_read_byte(&cTarsLength[LegIKLegNr])) {    // We allow mix of 3 and 4 DOF legs...
+        TarsToGroundAngle1 = -cTarsConst + cTarsMulti*IKFeetPosY + ((long)(IKFeetPosXZ*cTarsFactorA))/c1DEC - ((long)(IKFeetPosXZ*IKFeetPosY)/(cTarsFactorB));
+        if (IKFeetPosY < 0)     //Always compensate TarsToGroundAngle1 when IKFeetPosY it goes below zero
+            TarsToGroundAngle1 = TarsToGroundAngle1 - ((long)(IKFeetPosY*cTarsFactorC)/c1DEC);     //TGA base, overall rule
+        if (TarsToGroundAngle1 > 400)
+            TGA_B_H3 = 200 + (TarsToGroundAngle1/2);
+        else
+            TGA_B_H3 = TarsToGroundAngle1;
+
+        if (TarsToGroundAngle1 > 300)
+            TGA_A_H4 = 240 + (TarsToGroundAngle1/5);
+        else
+            TGA_A_H4 = TarsToGroundAngle1;
+
+        if (IKFeetPosY > 0)    //Only compensate the TarsToGroundAngle1 when it exceed 30 deg (A, H4 PEP note)
+            TarsToGroundAngle1 = TGA_A_H4;
+        else if (((IKFeetPosY <= 0) & (IKFeetPosY > -10))) // linear transition between case H3 and H4 (from PEP: H4-K5*(H3-H4))
+            TarsToGroundAngle1 = (TGA_A_H4 -(((long)IKFeetPosY*(TGA_B_H3-TGA_A_H4))/c1DEC));
+        else                //IKFeetPosY <= -10, Only compensate TGA1 when it exceed 40 deg
+            TarsToGroundAngle1 = TGA_B_H3;
+		
+        //Calc Tars Offsets:
+        GetSinCos(TarsToGroundAngle1);
+        TarsOffsetXZ = ((long)sin4*(byte)pgm_read_byte(&cTarsLength[LegIKLegNr]))/c4DEC;
+        TarsOffsetY = ((long)cos4*(byte)pgm_read_byte(&cTarsLength[LegIKLegNr]))/c4DEC;
+    } else {
+        TarsOffsetXZ = 0;
+        TarsOffsetY = 0;
+    }
+#endif
+    
+    //Using GetAtan2 for solving IKA1 and IKSW
+    //IKA14 - Angle between SW line and the ground in radians
+    IKA14 = GetATan2 (IKFeetPosY-TarsOffsetY, IKFeetPosXZ-(byte)pgm_read_byte(&cCoxaLength[LegIKLegNr])-TarsOffsetXZ);
+    
+    //IKSW2 - Length between femur axis and tars
+    IKSW2 = XYhyp2;
+    
+    //IKA2 - Angle of the line S>W with respect to the femur in radians
+    Temp1 = ((((long)(byte)pgm_read_byte(&cFemurLength[LegIKLegNr])*(byte)pgm_read_byte(&cFemurLength[LegIKLegNr])) - ((long)(byte)pgm_read_byte(&cTibiaLength[LegIKLegNr])*(byte)pgm_read_byte(&cTibiaLength[LegIKLegNr])))*c4DEC + ((long)IKSW2*IKSW2));
+    Temp2 = (long)(2*(byte)pgm_read_byte(&cFemurLength[LegIKLegNr]))*c2DEC * (unsigned long)IKSW2;
+    T3 = Temp1 / (Temp2/c4DEC);
+    IKA24 = GetArcCos (T3 );
+    //IKFemurAngle
+    FemurAngle1[LegIKLegNr] = -(long)(IKA14 + IKA24) * 180 / 3141 + 900 + CFEMURHORNOFFSET1(LegIKLegNr);
+
+    //IKTibiaAngle
+    Temp1 = ((((long)(byte)pgm_read_byte(&cFemurLength[LegIKLegNr])*(byte)pgm_read_byte(&cFemurLength[LegIKLegNr])) + ((long)(byte)pgm_read_byte(&cTibiaLength[LegIKLegNr])*(byte)pgm_read_byte(&cTibiaLength[LegIKLegNr])))*c4DEC - ((long)IKSW2*IKSW2));
+    Temp2 = (2*(byte)pgm_read_byte(&cFemurLength[LegIKLegNr])*(byte)pgm_read_byte(&cTibiaLength[LegIKLegNr]));
+    GetArcCos (Temp1 / Temp2);
+    TibiaAngle1[LegIKLegNr] = -(900-(long)AngleRad4*180/3141);
+
+#ifdef c4DOF
+    //Tars angle
+    if ((byte)pgm_read_byte(&cTarsLength[LegIKLegNr])) {    // We allow mix of 3 and 4 DOF legs...
+        TarsAngle1[LegIKLegNr] = (TarsToGroundAngle1 + FemurAngle1[LegIKLegNr] - TibiaAngle1[LegIKLegNr]) 
+             + CTARSHORNOFFSET1(LegIKLegNr);
+    }
+#endif
+
+    //Set the Solution quality    
+    if(IKSW2 < ((byte)pgm_read_byte(&cFemurLength[LegIKLegNr])+(byte)pgm_read_byte(&cTibiaLength[LegIKLegNr])-30)*c2DEC)
+        IKSolution = 1;
+    else
+    {
+        if(IKSW2 < ((byte)pgm_read_byte(&cFemurLength[LegIKLegNr])+(byte)pgm_read_byte(&cTibiaLength[LegIKLegNr]))*c2DEC) 
+            IKSolutionWarning = 1;
+        else
+            IKSolutionError = 1    ;
+    }
+}
+
+} // namespace OldMath
+
+//=============================================================================
+// Wrappers
+//=============================================================================
+SINCOS RefGetSinCos(short AngleDeg1)
+{
+    SINCOS  SinCos;
+
+    OldMath::sin4 = OldMath::cos4 = 0;
+    OldMath::GetSinCos(AngleDeg1);
+    SinCos.sin4 = OldMath::sin4;
+    SinCos.cos4 = OldMath::cos4;
+    return SinCos;
+}
+
+long RefGetArcCos(short cos4)
+{
+    OldMath::AngleRad4 = 0;
+    return OldMath::GetArcCos(cos4);
+}
+
+ATAN2 RefGetATan2(short AtanX, short AtanY)
+{
+    ATAN2   ATan2;
+
+    OldMath::AngleRad4 = 0;
+    ATan2.atan4 = OldMath::GetATan2(AtanX, AtanY);
+    ATan2.hyp2 = OldMath::XYhyp2;
+    return ATan2;
+}
+
+COORD3D RefBodyFK(short PosX, short PosZ, short PosY, short RotationY, byte BodyIKLeg)
+{
+    COORD3D Pos;
+
+    OldMath::BodyFK(PosX, PosZ, PosY, RotationY, BodyIKLeg);
+    Pos.x = OldMath::BodyFKPosX;
+    Pos.y = OldMath::BodyFKPosY;
+    Pos.z = OldMath::BodyFKPosZ;
+    return Pos;
+}
+
+LEGIKSOLUTION RefLegIK(short IKFeetPosX, short IKFeetPosY, short IKFeetPosZ, byte LegIKLegNr)
+{
+    LEGIKSOLUTION   IKSol;
+
+    memset(&IKSol, 0, sizeof(IKSol));
+    OldMath::AngleRad4 = 0;
+    OldMath::IKSolution = OldMath::IKSolutionWarning = OldMath::IKSolutionError = 0;
+    OldMath::LegIK(IKFeetPosX, IKFeetPosY, IKFeetPosZ, LegIKLegNr);
+    IKSol.CoxaAngle1 = OldMath::CoxaAngle1[LegIKLegNr];
+    IKSol.FemurAngle1 = OldMath::FemurAngle1[LegIKLegNr];
+    IKSol.TibiaAngle1 = OldMath::TibiaAngle1[LegIKLegNr];
+#ifdef c4DOF
+    if ((byte)pgm_read_byte(&OldMath::cTarsLength[LegIKLegNr]))
+        IKSol.TarsAngle1 = OldMath::TarsAngle1[LegIKLegNr];
+#endif
+    IKSol.bStatus = OldMath::IKSolution? cIKSolution : OldMath::IKSolutionWarning? cIKSolutionWarning : cIKSolutionError;
+    return IKSol;
+}
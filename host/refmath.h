@@ -0,0 +1,23 @@
+//==============================================================================
+// refmath.h - The sketch math the way it was before it returned its results.
+//
+// GetSinCos, GetArcCos, GetATan2, BodyFK and LegIK of the original sketch,
+// which left their results in globals, with their own copies of the tables.
+// hexbench -m checks the sketch's functions against them bit for bit.
+//==============================================================================
+#ifndef _REFMATH_H_
+#define _REFMATH_H_
+
+#include "Hex_Globals.h"
+
+SINCOS RefGetSinCos(short AngleDeg1);
+long RefGetArcCos(short cos4);
+ATAN2 RefGetATan2(short AtanX, short AtanY);
+
+// Reads the body rotation (g_InControlState.BodyRot1, TotalXBal1..) and
+// BodyRotOffsetX.. of the sketch, like the old BodyFK did
+COORD3D RefBodyFK(short PosX, short PosZ, short PosY, short RotationY, byte BodyIKLeg);
+
+LEGIKSOLUTION RefLegIK(short IKFeetPosX, short IKFeetPosY, short IKFeetPosZ, byte LegIKLegNr);
+
+#endif
@@ -0,0 +1,17 @@
+//==============================================================================
+// sketch_prototypes.h - Force-included ahead of Hexapod_Apod.ino on the host.
+//
+// The Arduino IDE adds "#include <Arduino.h>" and a prototype for every
+// function defined in the .ino before compiling it.  This header does the
+// same for the functions the sketch calls ahead of their definition.
+//==============================================================================
+#ifndef _SKETCH_PROTOTYPES_H_
+#define _SKETCH_PROTOTYPES_H_
+
+#include <Arduino.h>
+
+void StartUpdateServos(void);
+void TailControl(void);
+boolean TerminalMonitor(void);
+
+#endif // _SKETCH_PROTOTYPES_H_
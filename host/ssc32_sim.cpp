@@ -0,0 +1,191 @@
+//==============================================================================
+// ssc32_sim.cpp - Minimal SSC-32 model attached to the host Serial1 port.
+//==============================================================================
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include "Arduino.h"
+#include "ArduinoHost.h"
+#include "ssc32_sim.h"
+
+#define GPSEQ_PLAYTIME_MS   1500    // how long a started GP sequence "plays"
+#define GPSEQ_NUMDEFINED    3       // sequences 0..2 report as defined
+
+static SSC32SIMSTATS    s_stats;
+static uint16_t         s_awPulse[SSC32SIM_NUMCHANNELS];
+static uint16_t         s_awPending[SSC32SIM_NUMCHANNELS];
+static uint32_t         s_ulPendingMask;
+static unsigned long    s_ulMoveEnd;        // millis() when the current group move completes
+
+static char             s_szLine[512];
+static unsigned         s_cchLine;
+
+static uint8_t          s_abBin[3];         // binary command being assembled
+static unsigned         s_cbBin;
+
+static int              s_iGPSeq = -1;
+static unsigned long    s_ulGPPlayed;       // ms of the sequence played, at speed 100%
+static unsigned long    s_ulGPAt;           // millis() s_ulGPPlayed was last brought up to date
+static long             s_lGPSpeed = 100;   // SM, %
+
+// Plays the GP sequence up to now at the current speed (backwards does not rewind it)
+static void GPAdvance(void)
+{
+    unsigned long ulNow = millis();
+    if ((s_iGPSeq >= 0) && (s_lGPSpeed > 0))
+        s_ulGPPlayed += (ulNow - s_ulGPAt) * s_lGPSpeed / 100;
+    s_ulGPAt = ulNow;
+}
+
+static void Reply(const void *pv, size_t cb)
+{
+    Serial1.hostQueueRx((const uint8_t *)pv, cb);
+}
+
+static void CommitMove(unsigned long ulTime)
+{
+    for (uint8_t ch = 0; ch < SSC32SIM_NUMCHANNELS; ch++) {
+        if (s_ulPendingMask & (1UL << ch))
+            s_awPulse[ch] = s_awPending[ch];
+    }
+    s_ulPendingMask = 0;
+    s_ulMoveEnd = millis() + ulTime;
+    s_stats.cGroupMoves++;
+}
+
+static void SetPending(unsigned ch, unsigned pw)
+{
+    if (ch < SSC32SIM_NUMCHANNELS) {
+        s_awPending[ch] = (uint16_t)pw;
+        s_ulPendingMask |= 1UL << ch;
+    }
+    s_stats.cServoCmds++;
+}
+
+static void ProcessGroupMove(const char *psz)
+{
+    unsigned ch = 0;
+    bool fTime = false;
+    unsigned long ulTime = 0;
+
+    while (*psz) {
+        char c = *psz++;
+        char *pszEnd;
+        unsigned long ul = strtoul(psz, &pszEnd, 10);
+        if (pszEnd == psz)
+            continue;
+        psz = pszEnd;
+        switch (c) {
+            case '#': ch = (unsigned)ul; break;
+            case 'P': SetPending(ch, (unsigned)ul); break;
+            case 'T': fTime = true; ulTime = ul; break;
+            default: break;
+        }
+    }
+    if (s_ulPendingMask)
+        CommitMove(fTime ? ulTime : 0);
+}
+
+static void ProcessLine(const char *psz)
+{
+    if (*psz == '#') {
+        ProcessGroupMove(psz);
+    } else if (!strcmp(psz, "ver")) {
+        static const char szVer[] = "SSC32-V2.50GP\r";
+        Reply(szVer, sizeof(szVer) - 1);
+    } else if (!strcmp(psz, "Q")) {
+        Reply((millis() >= s_ulMoveEnd) ? "." : "+", 1);
+    } else if (!strcmp(psz, "QPL0")) {
+        uint8_t abStat[4] = {255, 0, 0, 0};
+        GPAdvance();
+        if ((s_iGPSeq >= 0) && (s_ulGPPlayed < GPSEQ_PLAYTIME_MS)) {
+            unsigned long ulLeft = GPSEQ_PLAYTIME_MS - s_ulGPPlayed;
+            uint8_t bStep = (uint8_t)(s_ulGPPlayed / 250);
+            abStat[0] = (uint8_t)s_iGPSeq;
+            abStat[1] = bStep;
+            abStat[2] = bStep + 1;
+            abStat[3] = (uint8_t)min(ulLeft / 10, 255UL);
+        } else {
+            s_iGPSeq = -1;
+        }
+        Reply(abStat, sizeof(abStat));
+    } else if (!strncmp(psz, "PL0", 3)) {
+        // PL0 [SQ<seq>] [SM<speed>] [ONCE]
+        const char *pszSQ = strstr(psz, "SQ");
+        const char *pszSM = strstr(psz, "SM");
+        GPAdvance();
+        if (pszSQ) {
+            s_iGPSeq = atoi(pszSQ + 2);
+            s_ulGPPlayed = 0;
+            s_lGPSpeed = 100;
+        }
+        if (pszSM) {
+            s_lGPSpeed = atol(pszSM + 2);
+            if (!s_lGPSpeed)
+                s_iGPSeq = -1;      // speed 0 stops the player
+        }
+    } else if (!strncmp(psz, "EER -", 5)) {
+        int iAddr = atoi(psz + 5);
+        const char *pszCnt = strchr(psz, ';');
+        int cb = pszCnt ? atoi(pszCnt + 1) : 1;
+        uint8_t ab[2] = {0xff, 0xff};
+        if (iAddr / 2 < GPSEQ_NUMDEFINED) {
+            ab[0] = 0x10;
+            ab[1] = (uint8_t)(iAddr / 2);
+        }
+        Reply(ab, min(cb, 2));
+    } else if ((psz[0] == 'R') && (psz[1] >= '0') && (psz[1] <= '9') && !strchr(psz, '=')) {
+        Reply("0\r", 2);
+    }
+}
+
+static void TxHook(const uint8_t *pb, size_t cb)
+{
+    while (cb--) {
+        uint8_t b = *pb++;
+        s_stats.cbRx++;
+        s_stats.ulDigest = (s_stats.ulDigest ^ b) * 16777619UL;
+
+        if (s_cbBin || ((b & 0x80) && !s_cchLine)) {
+            // Binary mode command: 0x80+ch or 0xA1 followed by a 16 bit value
+            s_abBin[s_cbBin++] = b;
+            if (s_cbBin == 3) {
+                unsigned w = ((unsigned)s_abBin[1] << 8) | s_abBin[2];
+                if (s_abBin[0] == 0xA1)
+                    CommitMove(w);
+                else if (s_abBin[0] < 0xA0)
+                    SetPending(s_abBin[0] - 0x80, w);
+                s_cbBin = 0;
+            }
+        } else if ((b == '\r') || (b == '\n')) {
+            s_szLine[s_cchLine] = '\0';
+            if (s_cchLine)
+                ProcessLine(s_szLine);
+            s_cchLine = 0;
+        } else if (s_cchLine < sizeof(s_szLine) - 1) {
+            s_szLine[s_cchLine++] = (char)b;
+        }
+    }
+}
+
+void SSC32SimAttach(void)
+{
+    SSC32SimResetStats();
+    Serial1.hostSetTxHook(TxHook);
+}
+
+const SSC32SIMSTATS *SSC32SimStats(void)
+{
+    return &s_stats;
+}
+
+void SSC32SimResetStats(void)
+{
+    memset(&s_stats, 0, sizeof(s_stats));
+    s_stats.ulDigest = 2166136261UL;
+}
+
+uint16_t SSC32SimPulse(uint8_t bChannel)
+{
+    return (bChannel < SSC32SIM_NUMCHANNELS) ? s_awPulse[bChannel] : 0;
+}
@@ -0,0 +1,32 @@
+//==============================================================================
+// ssc32_sim.h - Minimal SSC-32 model attached to the host Serial1 port.
+//
+// Parses what the sketch sends (ASCII group moves and binary mode commands)
+// and answers the queries the driver uses: ver, Q, QPL0, EER and R<reg>.  GP
+// sequences (PL0 SQ/SM/ONCE) "play" for a fixed time at the speed given.
+//==============================================================================
+#ifndef _SSC32_SIM_H_
+#define _SSC32_SIM_H_
+
+#include <stdint.h>
+
+#define SSC32SIM_NUMCHANNELS    32
+
+typedef struct _SSC32SimStats {
+    unsigned long   cGroupMoves;    // number of committed group moves (T terminated)
+    unsigned long   cServoCmds;     // number of #<ch>P<pw> (or binary) servo commands
+    unsigned long   cbRx;           // bytes received from the sketch
+    uint32_t        ulDigest;       // FNV-1a digest of every byte received
+} SSC32SIMSTATS;
+
+// Attach the model to Serial1.  Call before setup().
+void SSC32SimAttach(void);
+
+// Current statistics, and reset of the counters (digest included).
+const SSC32SIMSTATS *SSC32SimStats(void);
+void SSC32SimResetStats(void);
+
+// Last committed pulse width per channel (0 = off).
+uint16_t SSC32SimPulse(uint8_t bChannel);
+
+#endif // _SSC32_SIM_H_
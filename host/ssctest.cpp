@@ -0,0 +1,327 @@
+//==============================================================================
+// ssctest.cpp - Host tests of the SSC-32 servo driver.
+//
+// Frames: the bytes ServoDriver formats for the legs, mandibles, tail, free
+// servos and the move time have to be the ones the driver sent before it
+// built whole frames, when it printed each field with SSCSerial.print() (or
+// wrote it, in binary mode).  The old formatting is kept here as the
+// reference; every frame is compared byte for byte.
+//
+// Overlap (OPT_SSC_ASYNCTX): while walking, the frames have to go out on
+// the wire while the sketch works out the next one.  Over the walking cycles
+// of a short PS2 script the sketch may be blocked on the UART for at most
+// cTESTMAXTXBLOCK percent of the frames' wire time; sending them the old way
+// it is about half.
+//
+// The Makefile builds and runs it in ASCII, in binary mode and with
+// OPT_SSC_ASYNCTX (make test).  Exits non-zero when a test fails.
+//==============================================================================
+#include <stdio.h>
+#include <string.h>
+#include "Arduino.h"
+#include "ArduinoHost.h"
+#include "PS2X_lib.h"
+#include "ssc32_sim.h"
+#include "Hex_Globals.h"
+#include "ServoDriver.h"
+
+// The sketch sources are built with -finstrument-functions for hexbench
+extern "C" {
+void __cyg_profile_func_enter(void *pvFn, void *pvCallSite) {}
+void __cyg_profile_func_exit(void *pvFn, void *pvCallSite) {}
+}
+
+//=============================================================================
+// What went out on Serial1, and the reference written with Print
+//=============================================================================
+#define TESTFRAMESIZE   1024
+
+class FRAMEBUF : public Print {
+  public:
+    uint8_t     ab[TESTFRAMESIZE];
+    size_t      cb;
+
+    void Clear(void) { cb = 0; }
+    virtual size_t write(uint8_t b)
+    {
+        if (cb < sizeof(ab))
+            ab[cb++] = b;
+        return 1;
+    }
+    using Print::write;
+};
+
+static FRAMEBUF s_Sent;
+static FRAMEBUF s_Ref;
+
+static void TxCapture(const uint8_t *pb, size_t cb)
+{
+    s_Sent.write(pb, cb);
+}
+
+//=============================================================================
+// The old per-field output
+//=============================================================================
+#define cPwmDiv       991
+#define cPFConst      592
+
+static const byte s_abCoxaPin[]  = {cRRCoxaPin,  cRMCoxaPin,  cRFCoxaPin,  cLRCoxaPin,  cLMCoxaPin,  cLFCoxaPin};
+static const byte s_abFemurPin[] = {cRRFemurPin, cRMFemurPin, cRFFemurPin, cLRFemurPin, cLMFemurPin, cLFFemurPin};
+static const byte s_abTibiaPin[] = {cRRTibiaPin, cRMTibiaPin, cRFTibiaPin, cLRTibiaPin, cLMTibiaPin, cLFTibiaPin};
+#ifdef c4DOF
+static const byte s_abTarsPin[]  = {cRRTarsPin,  cRMTarsPin,  cRFTarsPin,  cLRTarsPin,  cLMTarsPin,  cLFTarsPin};
+static const byte s_abTarsLength[] = {cRRTarsLength, cRMTarsLength, cRFTarsLength, cLRTarsLength, cLMTarsLength, cLFTarsLength};
+#endif
+
+static word RefSSCV(short sAngle1)
+{
+    return ((long)(sAngle1 + 900))*1000/cPwmDiv + cPFConst;
+}
+
+static void RefServo(byte bPin, word wSSCV)
+{
+#ifdef cSSC_BINARYMODE
+    s_Ref.write(bPin + 0x80);
+    s_Ref.write(wSSCV >> 8);
+    s_Ref.write(wSSCV & 0xff);
+#else
+    s_Ref.print("#");
+    s_Ref.print(bPin, DEC);
+    s_Ref.print("P");
+    s_Ref.print(wSSCV, DEC);
+#endif
+}
+
+static void RefCommit(word wMoveTime)
+{
+#ifdef cSSC_BINARYMODE
+    s_Ref.write(0xA1);
+    s_Ref.write(wMoveTime >> 8);
+    s_Ref.write(wMoveTime & 0xff);
+#else
+    s_Ref.print("T");
+    s_Ref.println(wMoveTime, DEC);
+#endif
+}
+
+static void RefLeg(byte LegIndex, const short *psAngle1)
+{
+    short   sSign = (LegIndex < 3)? -1 : 1;     // the right legs are mirrored
+
+    RefServo(s_abCoxaPin[LegIndex], RefSSCV(sSign * psAngle1[0]));
+    RefServo(s_abFemurPin[LegIndex], RefSSCV(sSign * psAngle1[1]));
+    RefServo(s_abTibiaPin[LegIndex], RefSSCV(sSign * psAngle1[2]));
+#ifdef c4DOF
+    if (s_abTarsLength[LegIndex])
+        RefServo(s_abTarsPin[LegIndex], RefSSCV(sSign * psAngle1[3]));
+#endif
+}
+
+// The binary mandible output printed the last two servos as decimal text
+// into the binary stream; the reference is what it meant to write
+static void RefMandibles(short xRot, short yRot, short zRot, short lRot, short rRot)
+{
+    RefServo(cManRollPin, RefSSCV(-zRot));
+    RefServo(cManPitchPin, RefSSCV(-xRot));
+    RefServo(cManYawPin, RefSSCV(-yRot));
+    RefServo(cMandLeftPin, RefSSCV(lRot));
+    RefServo(cMandRightPin, RefSSCV(-rRot));
+}
+
+static void RefTails(short xRot, short yRot)
+{
+    RefServo(ctailPanPin, RefSSCV(-xRot));
+    RefServo(ctailPitchPin, RefSSCV(-yRot));
+}
+
+static void RefFreeServos(void)
+{
+    for (byte LegIndex = 0; LegIndex < 32; LegIndex++) {
+        s_Ref.print("#");
+        s_Ref.print(LegIndex, DEC);
+        s_Ref.print("P0");
+    }
+    s_Ref.print("T200\r");
+}
+
+//=============================================================================
+// Comparing
+//=============================================================================
+static unsigned long    s_cFrames;
+static unsigned long    s_cFailed;
+
+static void Begin(void)
+{
+    g_ServoDriver.InvalidateShadow();       // all servos, not only the ones that changed
+    g_ServoDriver.BeginServoUpdate();
+    s_Sent.Clear();
+    s_Ref.Clear();
+}
+
+static void Check(const char *pszWhat, int iArg)
+{
+    g_ServoDriver.TxFlush();
+    s_cFrames++;
+    if ((s_Sent.cb == s_Ref.cb) && !memcmp(s_Sent.ab, s_Ref.ab, s_Ref.cb))
+        return;
+    if (s_cFailed++ < 5) {
+        size_t i;
+        for (i = 0; (i < s_Sent.cb) && (i < s_Ref.cb) && (s_Sent.ab[i] == s_Ref.ab[i]); i++)
+            ;
+        printf("%s %d: %u bytes sent, %u expected, first difference at byte %u\n", pszWhat, iArg,
+               (unsigned)s_Sent.cb, (unsigned)s_Ref.cb, (unsigned)i);
+    }
+}
+
+static void OutputLeg(byte LegIndex, const short *psAngle1)
+{
+#ifdef c4DOF
+    g_ServoDriver.OutputServoInfoForLeg(LegIndex, psAngle1[0], psAngle1[1], psAngle1[2], psAngle1[3]);
+#else
+    g_ServoDriver.OutputServoInfoForLeg(LegIndex, psAngle1[0], psAngle1[1], psAngle1[2]);
+#endif
+}
+
+#ifdef OPT_LEGTEMPLATES
+template <byte LEG> static void OutputLegT(const short *psAngle1)
+{
+#ifdef c4DOF
+    g_ServoDriver.OutputServoInfoForLeg<LEG>(psAngle1[0], psAngle1[1], psAngle1[2], psAngle1[3]);
+#else
+    g_ServoDriver.OutputServoInfoForLeg<LEG>(psAngle1[0], psAngle1[1], psAngle1[2]);
+#endif
+}
+#endif
+
+static void TestFrames(void)
+{
+    short   asAngle1[4];
+    int     iAngle1;
+
+    // Legs: all six in one frame, each joint at a different angle from -90 to 90 deg
+    for (iAngle1 = -900; iAngle1 <= 900; iAngle1 += 3) {
+        Begin();
+        for (byte LegIndex = 0; LegIndex < 6; LegIndex++) {
+            for (int i = 0; i < 4; i++)
+                asAngle1[i] = ((iAngle1 + 1800 + LegIndex*97 + i*311) % 1801) - 900;
+            OutputLeg(LegIndex, asAngle1);
+            RefLeg(LegIndex, asAngle1);
+        }
+        g_ServoDriver.CommitServoDriver(iAngle1 + 1000);
+        RefCommit(iAngle1 + 1000);
+        Check("leg frame, angle", iAngle1);
+
+#ifdef OPT_LEGTEMPLATES
+        // The per leg versions StartUpdateServos uses
+        Begin();
+        for (byte LegIndex = 0; LegIndex < 6; LegIndex++) {
+            for (int i = 0; i < 4; i++)
+                asAngle1[i] = ((iAngle1 + 1800 + LegIndex*97 + i*311) % 1801) - 900;
+            switch (LegIndex) {
+            case cRR: OutputLegT<cRR>(asAngle1); break;
+            case cRM: OutputLegT<cRM>(asAngle1); break;
+            case cRF: OutputLegT<cRF>(asAngle1); break;
+            case cLR: OutputLegT<cLR>(asAngle1); break;
+            case cLM: OutputLegT<cLM>(asAngle1); break;
+            case cLF: OutputLegT<cLF>(asAngle1); break;
+            }
+            RefLeg(LegIndex, asAngle1);
+        }
+        g_ServoDriver.CommitServoDriver(iAngle1 + 1000);
+        RefCommit(iAngle1 + 1000);
+        Check("leg frame (templates), angle", iAngle1);
+#endif
+    }
+
+    // Mandibles and tail
+    for (iAngle1 = -900; iAngle1 <= 900; iAngle1 += 7) {
+        Begin();
+        g_ServoDriver.OutputServoInfoForMandibles(iAngle1, -iAngle1, iAngle1/2, 900 - abs(iAngle1), iAngle1/3);
+        RefMandibles(iAngle1, -iAngle1, iAngle1/2, 900 - abs(iAngle1), iAngle1/3);
+        g_ServoDriver.CommitServoDriver(200);
+        RefCommit(200);
+        Check("mandible frame, angle", iAngle1);
+
+        Begin();
+        g_ServoDriver.OutputServoInfoForTails(iAngle1, -iAngle1/2);
+        RefTails(iAngle1, -iAngle1/2);
+        g_ServoDriver.CommitServoDriver(200);
+        RefCommit(200);
+        Check("tail frame, angle", iAngle1);
+    }
+
+    // Move times from 0 to the largest, the digits of each length
+    for (long lTime = 0; lTime <= 0xffff; lTime = lTime*3 + 1) {
+        Begin();
+        g_ServoDriver.OutputServoInfoForTails(0, 0);
+        RefTails(0, 0);
+        g_ServoDriver.CommitServoDriver(lTime);
+        RefCommit(lTime);
+        Check("move time", lTime);
+    }
+
+    // Free servos, ASCII in both modes
+    Begin();
+    g_ServoDriver.FreeServos();
+    RefFreeServos();
+    Check("free servos", 0);
+}
+
+#ifdef OPT_SSC_ASYNCTX
+//=============================================================================
+// Overlap of the frames with the computing
+//=============================================================================
+#define cTESTMAXTXBLOCK     10      // % of the wire time
+
+extern void setup(void);
+extern void loop(void);
+
+static void RunCycles(int cCycles, uint16_t wPress, byte bLY)
+{
+    for (int iCycle = 0; iCycle < cCycles; iCycle++) {
+        PS2XStubSetState(iCycle? 0 : wPress, 128, bLY, 128, 128);
+        loop();
+    }
+}
+
+static bool FTestOverlap(void)
+{
+    SSC32SimAttach();
+    setup();
+    RunCycles(40, PSB_START, 128);              // power on and stand
+
+    unsigned long cbStart = Serial1.hostTxBytes();
+    unsigned long long nsBlockStart = HostTxBlockNanos();
+    RunCycles(120, 0, 0);                       // walk forward
+    double nsWire = (double)(Serial1.hostTxBytes() - cbStart) * Serial1.hostNsPerByte();
+    double dBlock = 100.0 * (HostTxBlockNanos() - nsBlockStart) / nsWire;
+
+    printf("ssctest overlap: walking, blocked on the UART %.1f%% of %.0f ms wire time (max %d%%)\n",
+           dBlock, nsWire / 1e6, cTESTMAXTXBLOCK);
+    return (nsWire > 0) && (dBlock <= cTESTMAXTXBLOCK);
+}
+#endif
+
+int main(int argc, char **argv)
+{
+    bool    fOK = true;
+
+    HostSetDeterministic(true);
+#ifdef OPT_SSC_ASYNCTX
+    fOK = FTestOverlap();
+#endif
+    SSC32SimAttach();                   // answers the version query of Init
+    g_ServoDriver.Init();
+    g_ServoDriver.TxFlush();
+    Serial1.hostSetTxHook(TxCapture);   // from here on only collect what is sent
+
+    TestFrames();
+    printf("ssctest (%s): %lu frames, %lu differ from the old formatting\n",
+#ifdef cSSC_BINARYMODE
+           "binary",
+#else
+           "ASCII",
+#endif
+           s_cFrames, s_cFailed);
+    return (fOK && !s_cFailed)? 0 : 1;
+}
@@ -11,10 +11,8 @@
 #endif
 #include "Hex_Globals.h"
 #include "ServoDriver.h"
-#ifdef c4DOF
-#define NUMSERVOSPERLEG 4
-#else
-#define NUMSERVOSPERLEG 3
+#ifdef OPT_LEGTEMPLATES
+#include "Hex_Robot.h"
 #endif
 
 #ifdef USE_SSC32
@@ -27,6 +25,7 @@ const byte cTibiaPin[] PROGMEM = {cRRTibiaPin, cRMTibiaPin, cRFTibiaPin, cLRTibi
 
 #ifdef c4DOF //[NATA]
 const byte cTarsPin[] PROGMEM = {cRRTarsPin, cRMTarsPin, cRFTarsPin, cLRTarsPin, cLMTarsPin, cLFTarsPin};
+static const byte cTarsLength[] PROGMEM = {cRRTarsLength, cRMTarsLength, cRFTarsLength, cLRTarsLength, cLMTarsLength, cLFTarsLength};
 #endif
 
 
@@ -46,8 +45,23 @@ const byte cTarsPin[] PROGMEM = {cRRTarsPin, cRMTarsPin, cRFTarsPin, cLRTarsPin,
 // Global - Local to this file only...
 //=============================================================================
 
-// definition of some helper functions
-extern int SSCRead (byte* pb, int cb, word wTimeout, word wEOL);
+#ifdef OPT_SSC_ASYNCTX
+// Without a hardware UART for the SSC-32 the frames are shifted out by a
+// Timer1 interrupt (a transmit only soft UART), SoftwareSerial is still used
+// for everything else.  With a hardware UART we keep feeding its TX ring.
+#if defined(__AVR__) && !defined(UBRR1H) && (cSSC_IN != 0)
+#define SSC_TIMERTX
+#endif
+
+static const byte * volatile s_pbTx;    // rest of the frame being sent
+static volatile word s_cbTx;
+#ifdef SSC_TIMERTX
+static volatile uint8_t *s_pbTxPort;    // output register and bit of cSSC_OUT
+static byte s_bTxMask;
+static byte s_bTxShift;                 // byte being shifted out
+static byte s_iTxBit;                   // 0 - start bit next, 1-8 data bits, 9 stop bit
+#endif
+#endif
 
 
 //--------------------------------------------------------------------
@@ -55,13 +69,32 @@ extern int SSCRead (byte* pb, int cb, word wTimeout, word wEOL);
 //--------------------------------------------------------------------
 void ServoDriver::Init(void) {
     SSCSerial.begin(cSSC_BAUD);
+    _pbFrame = _aabFrame[0];
+    InvalidateShadow();
+#ifdef SSC_TIMERTX
+    s_pbTxPort = portOutputRegister(digitalPinToPort(cSSC_OUT));
+    s_bTxMask = digitalPinToBitMask(cSSC_OUT);
+    TCCR1A = 0;
+    TCCR1B = _BV(WGM12) | _BV(CS10);                // CTC mode, no prescaler
+    OCR1A = (F_CPU + cSSC_BAUD/2) / cSSC_BAUD - 1;  // one tick per bit
+#endif
+    
+    _bQState = SSCQ_IDLE;
+    _bQFor = SSCQFOR_NONE;
+#ifdef OPT_SSC_MOVESYNC
+    _bMoveSync = MOVESYNC_DONE;
+#endif
+#ifdef OPT_IK_CACHE
+    _bLegPulsesValid = 0;
+#endif
     
 #ifdef OPT_GPPLAYER //Checks to see if the SSC-32 support the general purpose sequences
-    char abVer[40];        // give a nice large buffer.
-    byte cbRead;
-
     _fGPEnabled = false;  // starts off assuming that it is not enabled...
-    _fGPActive = false;
+    _bGPState = GPSTATE_IDLE;
+    _sGPSpeed = 100;
+    _bGPSeqDefined = 0;
+    _iGPScan = 0;
+    _ulFrameTime = millis() - cGP_SCANIDLE;
     
 #ifdef __AVR__
 #if not defined(UBRR1H)
@@ -70,23 +103,9 @@ void ServoDriver::Init(void) {
 #endif    
 #endif    
 #endif
+    // GPPlayer looks at the reply when it is in
+    SSCQueryStart(SSCQFOR_VER, SSC_QUERYSIZE, 13, 10);
     SSCSerial.print("ver\r");
-    cbRead = SSCRead((byte*)abVer, sizeof(abVer), 10000, 13);
-    
-#ifdef DBGSerial
-    DBGSerial.write("Check GP Enable: ");
-    if (cbRead > 0) {
-        byte iT;
-        for (iT = 0; iT < cbRead; iT++)
-            DBGSerial.print(abVer[iT], HEX);
-        DBGSerial.write((byte*)abVer, cbRead);
-    }
-    DBGSerial.print("\n\r");
-#endif        
-    if ((cbRead > 3) && (abVer[cbRead-3]=='G') && (abVer[cbRead-2]=='P') && (abVer[cbRead-1]==13))
-      _fGPEnabled = true;  // starts off assuming that it is not enabled...
-    else
-      MSound (SOUND_PIN, 2, 40, 2500, 40, 2500);
 #endif
 }
 
@@ -96,20 +115,12 @@ void ServoDriver::Init(void) {
 #ifdef OPT_GPPLAYER
 
 //--------------------------------------------------------------------
-//[FIsGPSeqDefined]
+//[FIsGPSeqDefined] From the lookup GPPlayer does after startup, false until
+//         the sequence has been found
 //--------------------------------------------------------------------
 boolean ServoDriver::FIsGPSeqDefined(uint8_t iSeq)
 {
-    word wGPSeqPtr;
-    
-    // See if we can see if this sequence is defined
-    SSCSerial.print("EER -");
-    SSCSerial.print(iSeq*2, DEC);
-    SSCSerial.println(";2");
-    if ((SSCRead((byte*)&wGPSeqPtr, sizeof(wGPSeqPtr), 1000, 0xffff) == sizeof(wGPSeqPtr)) && (wGPSeqPtr != 0)  && (wGPSeqPtr != 0xffff)) {
-      return true;
-    }
-  return false;  // nope return error
+    return (iSeq < cGP_NUMSEQS) && (_bGPSeqDefined & (1 << iSeq));
 }
 
 
@@ -118,56 +129,413 @@ boolean ServoDriver::FIsGPSeqDefined(uint8_t iSeq)
 //--------------------------------------------------------------------
 void ServoDriver::GPStartSeq(uint8_t iSeq)
 {
-    _fGPActive = true;
+    if (_bGPState != GPSTATE_IDLE)
+        return;
+    _bGPState = GPSTATE_START;
     _iSeq = iSeq;
+    _abGPStat[0] = iSeq;
+    _abGPStat[1] = 0;
+    _abGPStat[2] = 0;
+    _abGPStat[3] = 0;
 }
 
 //--------------------------------------------------------------------
-//[GP PLAYER]
+//[GPCancel] Stops the sequence where it is, the next frame takes the servos back
+//--------------------------------------------------------------------
+void ServoDriver::GPCancel(void)
+{
+    if (_bGPState == GPSTATE_IDLE)
+        return;
+    if (_bGPState != GPSTATE_START) {
+        SSCQueryWait();
+        TxFlush();
+        SSCSerial.print("PL0SM0\r");     // speed 0 stops the player
+    }
+    GPDone();
+}
+
+//--------------------------------------------------------------------
+//[GPSetSpeed] Speed of the sequence, also changes the one playing
+//--------------------------------------------------------------------
+void ServoDriver::GPSetSpeed(short sSpeed)
+{
+    sSpeed = min(max(sSpeed, -200), 200);
+    if (sSpeed == _sGPSpeed)
+        return;
+    _sGPSpeed = sSpeed;
+    if ((_bGPState == GPSTATE_WAIT) || (_bGPState == GPSTATE_QUERY)) {
+        SSCQueryWait();             // the QPL0 reply may be on its way
+        TxFlush();
+        SSCSerial.print("PL0SM");
+        SSCSerial.print(_sGPSpeed, DEC);
+        SSCSerial.print("\r");
+    }
+}
+
+//--------------------------------------------------------------------
+//[GPDone] The sequence is over: let the input controller back on the serial port
+//         and send all servos in the next frame
+//--------------------------------------------------------------------
+void ServoDriver::GPDone(void)
+{
+    if (_bGPState == GPSTATE_QUERY)
+        g_InputController.AllowControllerInterrupts(true);    // Ok to process hserial again...
+    InvalidateShadow();     // The sequence moved the servos behind our back
+    _bGPState = GPSTATE_IDLE;
+}
+
+//--------------------------------------------------------------------
+//[GPQueryDone] Takes the reply of the query GPPlayer had out
+//--------------------------------------------------------------------
+void ServoDriver::GPQueryDone(void)
+{
+    byte bFor = _bQFor;
+    byte bQ = _bQState;
+    
+    SSCQueryEnd();
+    switch (bFor) {
+    case SSCQFOR_VER:
+#ifdef DBGSerial
+        DBGSerial.write("Check GP Enable: ");
+        if (_cbQReply > 0) {
+            byte iT;
+            for (iT = 0; iT < _cbQReply; iT++)
+                DBGSerial.print(_abQReply[iT], HEX);
+            DBGSerial.write(_abQReply, _cbQReply);
+        }
+        DBGSerial.print("\n\r");
+#endif        
+        if ((_cbQReply > 3) && (_abQReply[_cbQReply-3]=='G') && (_abQReply[_cbQReply-2]=='P') && (_abQReply[_cbQReply-1]==13))
+            _fGPEnabled = true;
+        else
+            MSound (SOUND_PIN, 2, 40, 2500, 40, 2500);
+        break;
+
+    case SSCQFOR_GPSEQ:
+        // Pointer to the sequence, erased EEPROM or 0 when there is none
+        if ((bQ == SSCQ_DONE) && ((_abQReply[0] | _abQReply[1]) != 0) && ((_abQReply[0] & _abQReply[1]) != 0xff))
+            _bGPSeqDefined |= 1 << _iGPScan;
+        _iGPScan++;
+        break;
+
+    case SSCQFOR_GPSTAT:
+        if (_bGPState != GPSTATE_QUERY)
+            break;                  // Canceled while the query was out
+        //[GPStatSeq, GPStatFromStep, GPStatToStep, GPStatTime]
+        if (bQ != SSCQ_DONE) {
+            GPDone();               // No status, the player is gone
+            break;
+        }
+        memcpy(_abGPStat, _abQReply, sizeof(_abGPStat));
+        if ((_abGPStat[0] == 255) && (_abGPStat[1] == 0) && (_abGPStat[2] == 0) && (_abGPStat[3] == 0)) {
+            GPDone();               // Sequence complete
+            break;
+        }
+        g_InputController.AllowControllerInterrupts(true);
+        _ulGPTime = millis();
+        _bGPState = GPSTATE_WAIT;
+        break;
+    }
+}
+
+//--------------------------------------------------------------------
+//[GP PLAYER] Called once per loop.  Starts the sequence, then asks the SSC-32
+//         for its status every cGP_QUERYINTERVAL ms and picks up the reply when
+//         it is there, until the player reports it is done.  The frames of the
+//         loop are not sent while the sequence has the servos.  When no sequence
+//         plays it looks up one sequence in the SSC-32 EEPROM per call, but only
+//         after cGP_SCANIDLE ms without a frame, so the lookups stay out of the way
+//         of a walking robot.
 //--------------------------------------------------------------------
 void ServoDriver::GPPlayer(void)
 {
-    byte abStat[4];
-    byte cbRead;
+    if (SSCQueryPoll() == SSCQ_PENDING)
+        return;                     // wait for the reply, we only have one query
+    if (_bQState != SSCQ_IDLE)
+        GPQueryDone();
     
-    // BUGBUG:: Should integrate in the newer stuff to all us to control the speed of a sequence.
-    //Start sequence
-    if (_fGPActive) {
-        g_InputController.AllowControllerInterrupts(false);    // If on xbee on hserial tell hserial to not processess...
-        
+    switch (_bGPState) {
+    case GPSTATE_IDLE:
+        if (_fGPEnabled && (_iGPScan < cGP_NUMSEQS) && ((millis() - _ulFrameTime) >= cGP_SCANIDLE)
+                && SSCQueryStart(SSCQFOR_GPSEQ, 2, SSC_NOEOL, 5)) {
+            SSCSerial.print("EER -");
+            SSCSerial.print(_iGPScan*2, DEC);
+            SSCSerial.println(";2");
+        }
+        break;
+
+    case GPSTATE_START:
+        TxFlush();
+        while (SSCSerial.available())
+            SSCSerial.read();       // get rid of anything that was previously queued up...
         SSCSerial.print("PL0SQ");
         SSCSerial.print(_iSeq, DEC);
-        SSCSerial.println("ONCE"); //Start sequence
-        delay(20);
-        SSCSerial.flush();        // get rid of anything that was previously queued up...
-    
-        //Wait for GPPlayer to complete sequence    
-        do {
-            SSCSerial.print("QPL0\r");
-            cbRead = SSCRead((byte*)abStat, sizeof(abStat), 10000, (word)-1);  //    [GPStatSeq, GPStatFromStep, GPStatToStep, GPStatTime]
-            delay(20);
+        if (_sGPSpeed != 100) {
+            SSCSerial.print("SM");
+            SSCSerial.print(_sGPSpeed, DEC);
         }
-        while ((cbRead == sizeof(abStat)) && ((abStat[0]!=255) || (abStat[1]!=0) || (abStat[2]!=0) || (abStat[3]!=0)));
-
-        g_InputController.AllowControllerInterrupts(true);    // Ok to process hserial again...
+        SSCSerial.print("ONCE\r"); //Start sequence
+        _ulGPTime = millis();
+        _bGPState = GPSTATE_WAIT;
+        break;
+
+    case GPSTATE_WAIT:
+        if ((millis() - _ulGPTime) < cGP_QUERYINTERVAL)
+            break;
+        if (!SSCQueryStart(SSCQFOR_GPSTAT, sizeof(_abGPStat), SSC_NOEOL, cGP_REPLYTIMEOUT))
+            break;
+        g_InputController.AllowControllerInterrupts(false);    // If on xbee on hserial tell hserial to not processess...
+        SSCSerial.print("QPL0\r");
+        _bGPState = GPSTATE_QUERY;
+        break;
 
-        _fGPActive=false;
-    }  
+    case GPSTATE_QUERY:
+        GPDone();                   // The query was dropped (FindServoOffsets)
+        break;
+    }
 }
 #endif // OPT_GPPLAYER
 
+//------------------------------------------------------------------------------------------
+//[SSCFormatDec] Formats a number as ASCII decimal without leading zeros.  Uses repeated
+//         subtraction of the powers of ten, so there are no 32 bit divides like print() does.
+//------------------------------------------------------------------------------------------
+static const word c_awPow10[] PROGMEM = {10000, 1000, 100, 10};
+
+static byte *SSCFormatDec(byte *pb, word w)
+{
+    boolean fDigits = false;
+    for (byte i = 0; i < 4; i++) {
+        word wPow10 = pgm_read_word(&c_awPow10[i]);
+        byte bDigit = '0';
+        while (w >= wPow10) {
+            w -= wPow10;
+            bDigit++;
+        }
+        if (fDigits || (bDigit != '0')) {
+            *pb++ = bDigit;
+            fDigits = true;
+        }
+    }
+    *pb++ = '0' + (byte)w;
+    return pb;
+}
+
+//------------------------------------------------------------------------------------------
+//[FrameAddServo] Appends one servo move to the frame we are building
+//         ASCII: #<pin>P<pulse>    Binary: <0x80+pin><pulse hi><pulse lo>
+//------------------------------------------------------------------------------------------
+void ServoDriver::FrameAddServo(byte bPin, word wPulse)
+{
+    byte *pb = &_pbFrame[_cbFrame];
+#ifdef cSSC_BINARYMODE
+    *pb++ = bPin + 0x80;
+    *pb++ = wPulse >> 8;
+    *pb++ = wPulse & 0xff;
+#else
+    *pb++ = '#';
+    pb = SSCFormatDec(pb, bPin);
+    *pb++ = 'P';
+    pb = SSCFormatDec(pb, wPulse);
+#endif
+#ifdef OPT_ADAPTIVE_MOVETIME
+    word wDelta = (wPulse > _awShadow[bPin])? wPulse - _awShadow[bPin] : _awShadow[bPin] - wPulse;
+    if (wDelta > _wMaxDelta)
+        _wMaxDelta = wDelta;
+#endif
+#ifdef OPT_SSC_DELTAUPDATES
+    if (!_fFullFrame && (_awShadow[bPin] == wPulse)) {
+        // The SSC-32 already has this pulse, so leave it out of the frame
+        _cServosSkipped++;
+        _cbSaved += pb - &_pbFrame[_cbFrame];
+        return;
+    }
+    _awShadow[bPin] = wPulse;
+#elif defined(OPT_ADAPTIVE_MOVETIME)
+    _awShadow[bPin] = wPulse;
+#endif
+    _cbFrame = pb - _pbFrame;
+}
+
+//------------------------------------------------------------------------------------------
+//[FrameSend] Sends the frame we built to the SSC-32 and empties it.  With OPT_SSC_ASYNCTX
+//         this only waits for the previous frame and starts this one; the next frame is
+//         built in the other buffer while this one goes out.
+//------------------------------------------------------------------------------------------
+void ServoDriver::FrameSend(void)
+{
+    SSCQueryWait();
+#ifdef OPT_SSC_ASYNCTX
+    TxFlush();
+    TxBeginFrame();
+    s_pbTx = _pbFrame;
+    s_cbTx = _cbFrame;
+#ifdef SSC_TIMERTX
+    s_iTxBit = 0;
+    TCNT1 = 0;
+    TIFR1 = _BV(OCF1A);
+    TIMSK1 |= _BV(OCIE1A);
+#else
+    TxService();
+#endif
+    _pbFrame = (_pbFrame == _aabFrame[0])? _aabFrame[SSC_NUMFRAMEBUFS-1] : _aabFrame[0];
+#else
+    TxBeginFrame();
+    SSCSerial.write(_pbFrame, _cbFrame);
+    TxEndFrame();
+#endif
+    _cbFrame = 0;
+#ifdef OPT_GPPLAYER
+    _ulFrameTime = millis();
+#endif
+#ifdef OPT_SSC_DELTAUPDATES
+    _cFramesSent++;
+#endif
+}
+
+//------------------------------------------------------------------------------------------
+//[TxBeginFrame/TxEndFrame] The critical section around sending one frame
+//------------------------------------------------------------------------------------------
+void ServoDriver::TxBeginFrame(void)
+{
+    g_InputController.AllowControllerInterrupts(false);    // If on xbee on hserial tell hserial to not processess...
+    _fTxFrame = true;
+}
+
+void ServoDriver::TxEndFrame(void)
+{
+    if (_fTxFrame) {
+        _fTxFrame = false;
+        g_InputController.AllowControllerInterrupts(true);
+    }
+}
+
+//------------------------------------------------------------------------------------------
+//[TxService] Hands as much of the frame to the UART as fits in its TX ring, and ends
+//         the frame critical section when the frame is done
+//------------------------------------------------------------------------------------------
+void ServoDriver::TxService(void)
+{
+#ifdef OPT_SSC_ASYNCTX
+#ifdef SSC_TIMERTX
+    if (TIMSK1 & _BV(OCIE1A))
+        return;
+#else
+    if (s_cbTx) {
+        word cb = min((word)SSCSerial.availableForWrite(), s_cbTx);
+        SSCSerial.write(s_pbTx, cb);
+        s_pbTx += cb;
+        s_cbTx -= cb;
+        if (s_cbTx)
+            return;
+    }
+#endif
+    TxEndFrame();
+#endif
+}
+
+//------------------------------------------------------------------------------------------
+//[TxFlush] Waits for the frame to go out.  Needed before anything else is written to
+//         the SSC-32 or the frame buffer is reused.
+//------------------------------------------------------------------------------------------
+void ServoDriver::TxFlush(void)
+{
+#ifdef OPT_SSC_ASYNCTX
+#ifdef SSC_TIMERTX
+    while (TIMSK1 & _BV(OCIE1A))
+        ;
+#else
+    if (s_cbTx) {
+        SSCSerial.write(s_pbTx, s_cbTx);    // let the serial driver block for the rest
+        s_cbTx = 0;
+    }
+#endif
+    TxEndFrame();
+#endif
+}
+
+//------------------------------------------------------------------------------------------
+//[TxDelay] delay() that keeps the frame going out while we wait
+//------------------------------------------------------------------------------------------
+void ServoDriver::TxDelay(word wMS)
+{
+#if defined(OPT_SSC_ASYNCTX) && !defined(SSC_TIMERTX)
+    while (wMS && s_cbTx) {
+        TxService();
+        delay(1);
+        wMS--;
+    }
+    TxService();
+#endif
+    delay(wMS);
+}
+
+#ifdef SSC_TIMERTX
+//------------------------------------------------------------------------------------------
+// Timer1 compare interrupt, once per bit time: shifts out the frame 8N1, LSB first
+//------------------------------------------------------------------------------------------
+ISR(TIMER1_COMPA_vect)
+{
+    if (s_iTxBit == 0) {
+        if (!s_cbTx) {
+            TIMSK1 &= ~_BV(OCIE1A);             // stop bit is out, frame done
+            return;
+        }
+        s_bTxShift = *s_pbTx++;
+        s_cbTx--;
+        *s_pbTxPort &= ~s_bTxMask;              // start bit
+    } else if (s_iTxBit <= 8) {
+        if (s_bTxShift & 1)
+            *s_pbTxPort |= s_bTxMask;
+        else
+            *s_pbTxPort &= ~s_bTxMask;
+        s_bTxShift >>= 1;
+    } else {
+        *s_pbTxPort |= s_bTxMask;               // stop bit
+        s_iTxBit = 0;
+        return;
+    }
+    s_iTxBit++;
+}
+#endif
+
+//------------------------------------------------------------------------------------------
+//[InvalidateShadow] Called when the servos on the SSC-32 may no longer be where we last
+//         told them to go (startup, free servos, GP sequences...), so the next frame
+//         sends all of them
+//------------------------------------------------------------------------------------------
+void ServoDriver::InvalidateShadow(void)
+{
+#ifdef OPT_SSC_DELTAUPDATES
+    _bFramesToRefresh = 0;
+#endif
+#ifdef OPT_ADAPTIVE_MOVETIME
+    _fPosKnown = false;
+#endif
+}
+
 //------------------------------------------------------------------------------------------
 //[BeginServoUpdate] Does whatever preperation that is needed to starrt a move of our servos
 //------------------------------------------------------------------------------------------
 void ServoDriver::BeginServoUpdate(void)    // Start the update 
 {
+    _cbFrame = 0;
+#ifdef OPT_ADAPTIVE_MOVETIME
+    _wMaxDelta = _fPosKnown? 0 : 0xffff;
+#endif
+#ifdef OPT_SSC_DELTAUPDATES
+    _fFullFrame = (_bFramesToRefresh == 0);
+    if (_fFullFrame)
+        _bFramesToRefresh = cSSC_FULLREFRESH;
+    _bFramesToRefresh--;
+#endif
 }
 
 
 // Note: this is the function moving the servos
 //------------------------------------------------------------------------------------------
-//[OutputServoInfoForLeg] Do the output to the SSC-32 for the servos associated with
-//         the Leg number passed in.
+//[OutputServoInfoForLeg] Adds the servos associated with the Leg number passed in
+//         to the SSC-32 frame.
 //------------------------------------------------------------------------------------------
 #define cPwmDiv       991  //old 1059;
 #define cPFConst      592  //old 650 ; 900*(1000/cPwmDiv)+cPFConst must always be 1500
@@ -185,11 +553,25 @@ void ServoDriver::OutputServoInfoForLeg(byte LegIndex, short sCoxaAngle1, short
 #ifdef c4DOF
     word    wTarsSSCV;        //
 #endif
+#ifdef OPT_IK_CACHE
+#ifdef c4DOF
+    short   asAngle1[NUMSERVOSPERLEG] = {sCoxaAngle1, sFemurAngle1, sTibiaAngle1, sTarsAngle1};
+#else
+    short   asAngle1[NUMSERVOSPERLEG] = {sCoxaAngle1, sFemurAngle1, sTibiaAngle1};
+#endif
+    word    awPulse[NUMSERVOSPERLEG];
 
-// TODO: remove after testing
+    if (FLegPulsesKept(LegIndex, asAngle1, awPulse)) {
+        wCoxaSSCV = awPulse[0];
+        wFemurSSCV = awPulse[1];
+        wTibiaSSCV = awPulse[2];
+#ifdef c4DOF
+        wTarsSSCV = awPulse[3];
+#endif
+    } else
+#endif
 
     //Update Right Legs
-    g_InputController.AllowControllerInterrupts(false);    // If on xbee on hserial tell hserial to not processess...
     if (LegIndex < 3) {
         wCoxaSSCV = ((long)(-sCoxaAngle1 +900))*1000/cPwmDiv+cPFConst;
         wFemurSSCV = ((long)(-sFemurAngle1+900))*1000/cPwmDiv+cPFConst;
@@ -205,54 +587,107 @@ void ServoDriver::OutputServoInfoForLeg(byte LegIndex, short sCoxaAngle1, short
         wTarsSSCV = ((long)(sTarsAngle1+900))*1000/cPwmDiv+cPFConst;
 #endif
     }
+#ifdef OPT_IK_CACHE
+    awPulse[0] = wCoxaSSCV;
+    awPulse[1] = wFemurSSCV;
+    awPulse[2] = wTibiaSSCV;
+#ifdef c4DOF
+    awPulse[3] = wTarsSSCV;
+#endif
+    LegPulsesKeep(LegIndex, asAngle1, awPulse);
+#endif
 
-#ifdef cSSC_BINARYMODE
-    SSCSerial.write(pgm_read_byte(&cCoxaPin[LegIndex])  + 0x80);
-    SSCSerial.write(wCoxaSSCV >> 8);
-    SSCSerial.write(wCoxaSSCV & 0xff);
-    SSCSerial.write(pgm_read_byte(&cFemurPin[LegIndex]) + 0x80);
-    SSCSerial.write(wFemurSSCV >> 8);
-    SSCSerial.write(wFemurSSCV & 0xff);
-    SSCSerial.write(pgm_read_byte(&cTibiaPin[LegIndex]) + 0x80);
-    SSCSerial.write(wTibiaSSCV >> 8);
-    SSCSerial.write(wTibiaSSCV & 0xff);
+    FrameAddServo(pgm_read_byte(&cCoxaPin[LegIndex]), wCoxaSSCV);
+    FrameAddServo(pgm_read_byte(&cFemurPin[LegIndex]), wFemurSSCV);
+    FrameAddServo(pgm_read_byte(&cTibiaPin[LegIndex]), wTibiaSSCV);
 #ifdef c4DOF
-    if ((byte)pgm_read_byte(&cTarsLength[LegIndex])) {    // We allow mix of 3 and 4 DOF legs...
-        SSCSerial.write(pgm_read_byte(&cTarsPin[LegIndex]) + 0x80);
-        SSCSerial.write(wTarsSSCV >> 8);
-        SSCSerial.write(wTarsSSCV & 0xff);
-    }
+    if ((byte)pgm_read_byte(&cTarsLength[LegIndex]))     // We allow mix of 3 and 4 DOF legs...
+        FrameAddServo(pgm_read_byte(&cTarsPin[LegIndex]), wTarsSSCV);
 #endif
+}
+
+#ifdef OPT_IK_CACHE
+//------------------------------------------------------------------------------------------
+//[FLegPulsesKept] True when the leg has the same angles as the last time, pwPulse gets
+//         the pulses of them
+//------------------------------------------------------------------------------------------
+boolean ServoDriver::FLegPulsesKept(byte LegIndex, const short *psAngle1, word *pwPulse)
+{
+    if (!(_bLegPulsesValid & (1 << LegIndex)) 
+            || memcmp(_aasLegAngle1[LegIndex], psAngle1, sizeof(_aasLegAngle1[0])))
+        return false;
+    memcpy(pwPulse, _aawLegPulse[LegIndex], sizeof(_aawLegPulse[0]));
+    return true;
+}
+
+void ServoDriver::LegPulsesKeep(byte LegIndex, const short *psAngle1, const word *pwPulse)
+{
+    memcpy(_aasLegAngle1[LegIndex], psAngle1, sizeof(_aasLegAngle1[0]));
+    memcpy(_aawLegPulse[LegIndex], pwPulse, sizeof(_aawLegPulse[0]));
+    _bLegPulsesValid |= 1 << LegIndex;
+}
+#endif
+
+#ifdef OPT_LEGTEMPLATES
+//------------------------------------------------------------------------------------------
+//[OutputServoInfoForLeg<LEG>] As above for one leg, the right legs are mirrored
+//------------------------------------------------------------------------------------------
+template <byte LEG> inline word LegSSCV(short sAngle1)
+{
+    if (LEGDESC<LEG>::fLeft)
+        return ((long)(sAngle1 +900))*1000/cPwmDiv+cPFConst;
+    return ((long)(-sAngle1 +900))*1000/cPwmDiv+cPFConst;
+}
+
+#ifdef c4DOF
+template <byte LEG> void ServoDriver::OutputServoInfoForLeg(short sCoxaAngle1, short sFemurAngle1, short sTibiaAngle1, short sTarsAngle1)
 #else
-    //The format for writing to the SSC32 can be found in it's documentation for our purpose
-    //# signals the start of a command + {Pin Number} + P signals the start of the speeed + {Pulse}
-    //The serial object is setup with the correct baud rate, at this point we have abstracted talking to the servo controller
-    //enough where we can send a word object
-    //TODO: Make this a function 
-    SSCSerial.print("#");
-    SSCSerial.print(pgm_read_byte(&cCoxaPin[LegIndex]), DEC);
-    SSCSerial.print("P");
-    SSCSerial.print(wCoxaSSCV, DEC);
-    SSCSerial.print("#");
-    SSCSerial.print(pgm_read_byte(&cFemurPin[LegIndex]), DEC);
-    SSCSerial.print("P");
-    SSCSerial.print(wFemurSSCV, DEC);
-    SSCSerial.print("#");
-    SSCSerial.print(pgm_read_byte(&cTibiaPin[LegIndex]), DEC);
-    SSCSerial.print("P");
-    SSCSerial.print(wTibiaSSCV, DEC);
+template <byte LEG> void ServoDriver::OutputServoInfoForLeg(short sCoxaAngle1, short sFemurAngle1, short sTibiaAngle1)
+#endif
+{
+    word    awPulse[NUMSERVOSPERLEG];
+#ifdef OPT_IK_CACHE
+#ifdef c4DOF
+    short   asAngle1[NUMSERVOSPERLEG] = {sCoxaAngle1, sFemurAngle1, sTibiaAngle1, sTarsAngle1};
+#else
+    short   asAngle1[NUMSERVOSPERLEG] = {sCoxaAngle1, sFemurAngle1, sTibiaAngle1};
+#endif
+
+    if (!FLegPulsesKept(LEG, asAngle1, awPulse))
+#endif
+    {
+        awPulse[0] = LegSSCV<LEG>(sCoxaAngle1);
+        awPulse[1] = LegSSCV<LEG>(sFemurAngle1);
+        awPulse[2] = LegSSCV<LEG>(sTibiaAngle1);
 #ifdef c4DOF
-    if ((byte)pgm_read_byte(&cTarsLength[LegIndex])) {
-        SSCSerial.print("#");
-        SSCSerial.print(pgm_read_byte(&cTarsPin[LegIndex]), DEC);
-        SSCSerial.print("P");
-        SSCSerial.print(wTarsSSCV, DEC);
+        awPulse[3] = LegSSCV<LEG>(sTarsAngle1);
+#endif
+#ifdef OPT_IK_CACHE
+        LegPulsesKeep(LEG, asAngle1, awPulse);
+#endif
     }
+    FrameAddServo(LEGDESC<LEG>::CoxaPin, awPulse[0]);
+    FrameAddServo(LEGDESC<LEG>::FemurPin, awPulse[1]);
+    FrameAddServo(LEGDESC<LEG>::TibiaPin, awPulse[2]);
+#ifdef c4DOF
+    if (LEGDESC<LEG>::TarsLength)
+        FrameAddServo(LEGDESC<LEG>::TarsPin, awPulse[3]);
 #endif
-#endif        
-    g_InputController.AllowControllerInterrupts(true);    // Ok for hserial again...
 }
 
+#ifdef c4DOF
+#define LEGOUTPUT_INST(LEG) template void ServoDriver::OutputServoInfoForLeg<LEG>(short, short, short, short);
+#else
+#define LEGOUTPUT_INST(LEG) template void ServoDriver::OutputServoInfoForLeg<LEG>(short, short, short);
+#endif
+LEGOUTPUT_INST(cRR)
+LEGOUTPUT_INST(cRM)
+LEGOUTPUT_INST(cRF)
+LEGOUTPUT_INST(cLR)
+LEGOUTPUT_INST(cLM)
+LEGOUTPUT_INST(cLF)
+#endif
+
 void ServoDriver::OutputServoInfoForMandibles(short xRot, short yRot, short zRot, short lRot, short rRot)
 {
   word    wXRotSSCV;
@@ -261,9 +696,6 @@ void ServoDriver::OutputServoInfoForMandibles(short xRot, short yRot, short zRot
   word    wLRotSSCV;  
   word    wRRotSSCV;
 
-  // Disable interrupts
-  g_InputController.AllowControllerInterrupts(false);
-  
   // Set up words
    wXRotSSCV = ((long)(-xRot +900))*1000/cPwmDiv+cPFConst;
    wYRotSSCV = ((long)(-yRot +900))*1000/cPwmDiv+cPFConst;
@@ -271,59 +703,11 @@ void ServoDriver::OutputServoInfoForMandibles(short xRot, short yRot, short zRot
    wLRotSSCV = ((long)(lRot +900))*1000/cPwmDiv+cPFConst;
    wRRotSSCV = ((long)(-rRot +900))*1000/cPwmDiv+cPFConst;
    
-// Do some writing 
-#ifdef cSSC_BINARYMODE
-    SSCSerial.write((byte)cManRollPin + 0x80);
-    SSCSerial.write(wZRotSSCV >> 8 );
-    SSCSerial.write(wZRotSSCV & 0xff);
-    
-    SSCSerial.write((byte)cManPitchPin + 0x80);
-    SSCSerial.write(wXRotSSCV >> 8 );
-    SSCSerial.write(wXRotSSCV & 0xff);
-    
-    SSCSerial.write((byte)cManYawPin + 0x80);
-    SSCSerial.write(wYRotSSCV >> 8 );
-    SSCSerial.write(wYRotSSCV & 0xff);
-
-    SSCSerial.print((byte)cManYawPin + 0x80);
-    SSCSerial.print((byte)cMandLeftPin, DEC);
-    SSCSerial.print(wLRotSSCV >> 8 );
-    SSCSerial.print(wLRotSSCV & 0xff);
-
-    SSCSerial.print((byte)cManYawPin + 0x80);
-    SSCSerial.print((byte)cMandRightPin, DEC);
-    SSCSerial.print(wRRotSSCV >> 8 );
-    SSCSerial.print(wRRotSSCV & 0xff);
-#else
-    SSCSerial.print("#");
-    SSCSerial.print((byte)cManRollPin, DEC);
-    SSCSerial.print("P");
-    SSCSerial.print(wZRotSSCV, DEC);
-    
-    SSCSerial.print("#");
-    SSCSerial.print((byte)cManPitchPin, DEC);
-    SSCSerial.print("P");
-    SSCSerial.print(wXRotSSCV, DEC);
-    
-    SSCSerial.print("#");
-    SSCSerial.print((byte)cManYawPin, DEC);
-    SSCSerial.print("P");
-    SSCSerial.print(wYRotSSCV, DEC);
-
-    SSCSerial.print("#");
-    SSCSerial.print((byte)cMandLeftPin, DEC);
-    SSCSerial.print("P");
-    SSCSerial.print(wLRotSSCV, DEC);
-
-    SSCSerial.print("#");
-    SSCSerial.print((byte)cMandRightPin, DEC);
-    SSCSerial.print("P");
-    SSCSerial.print(wRRotSSCV, DEC);
-
-#endif  
-
-  // Re-enable interrupts
-  g_InputController.AllowControllerInterrupts(true);
+   FrameAddServo(cManRollPin, wZRotSSCV);
+   FrameAddServo(cManPitchPin, wXRotSSCV);
+   FrameAddServo(cManYawPin, wYRotSSCV);
+   FrameAddServo(cMandLeftPin, wLRotSSCV);
+   FrameAddServo(cMandRightPin, wRRotSSCV);
 }
 
 //--------------------------------------------------------------------
@@ -335,80 +719,96 @@ void ServoDriver::OutputServoInfoForTails(short xRot, short yRot)
   word    wXRotSSCV;
   word    wYRotSSCV;
   
-  // Disable interrupts
-  g_InputController.AllowControllerInterrupts(false);
-  
   // Set up words
   wXRotSSCV = ((long)(-xRot +900))*1000/cPwmDiv+cPFConst;
   wYRotSSCV = ((long)(-yRot +900))*1000/cPwmDiv+cPFConst;
 
-// Do some writing 
-#ifdef cSSC_BINARYMODE
-    SSCSerial.write((byte)ctailPanPin + 0x80);
-    SSCSerial.write(wXRotSSCV >> 8 );
-    SSCSerial.write(wXRotSSCV & 0xff);
-    
-    SSCSerial.write((byte)ctailPitchPin + 0x80);
-    SSCSerial.write(wYRotSSCV >> 8 );
-    SSCSerial.write(wYRotSSCV & 0xff);
-#else
-    SSCSerial.print("#");
-    SSCSerial.print((byte)ctailPanPin, DEC);
-    SSCSerial.print("P");
-    SSCSerial.print(wXRotSSCV, DEC);
-
-    SSCSerial.print("#");
-    SSCSerial.print((byte)ctailPitchPin, DEC);
-    SSCSerial.print("P");
-    SSCSerial.print(wYRotSSCV, DEC);
-
-#endif  
-  // Re-enable interrupts
-  g_InputController.AllowControllerInterrupts(true);
+  FrameAddServo(ctailPanPin, wXRotSSCV);
+  FrameAddServo(ctailPitchPin, wYRotSSCV);
 }
 
 //--------------------------------------------------------------------
-//[CommitServoDriver Updates the positions of the servos - This outputs
-//         as much of the command as we can without committing it.  This
-//         allows us to once the previous update was completed to quickly 
-//        get the next command to start
+//[CommitServoDriver Updates the positions of the servos - This adds
+//         the move time to the frame built since BeginServoUpdate and
+//         sends it to the SSC-32 in one go
 //--------------------------------------------------------------------
 void ServoDriver::CommitServoDriver(word wMoveTime)
 {
-#ifdef cSSC_BINARYMODE
-    byte    abOut[3];
+#ifdef OPT_GPPLAYER
+    if (_bGPState != GPSTATE_IDLE) {
+        // The sequence has the servos
+        _cbFrame = 0;
+        return;
+    }
+#endif
+#ifdef OPT_ADAPTIVE_MOVETIME
+    if (_cbFrame)
+        _fPosKnown = true;          // after this move they are where the shadow says
+#endif
+#ifdef OPT_SSC_DELTAUPDATES
+    word cbServos = _cbFrame;
 #endif
-    
-    g_InputController.AllowControllerInterrupts(false);    // If on xbee on hserial tell hserial to not processess...
-
 #ifdef cSSC_BINARYMODE
-    abOut[0] = 0xA1;
-    abOut[1] = wMoveTime >> 8;
-    abOut[2] = wMoveTime & 0xff;
-    SSCSerial.write(abOut, 3);
+    _pbFrame[_cbFrame++] = 0xA1;
+    _pbFrame[_cbFrame++] = wMoveTime >> 8;
+    _pbFrame[_cbFrame++] = wMoveTime & 0xff;
 #else
       //Send <CR>
-    SSCSerial.print("T");
-    SSCSerial.println(wMoveTime, DEC);
+    byte *pb = &_pbFrame[_cbFrame];
+    *pb++ = 'T';
+    pb = SSCFormatDec(pb, wMoveTime);
+    *pb++ = '\r';
+    *pb++ = '\n';
+    _cbFrame = pb - _pbFrame;
 #endif
+#ifdef OPT_SSC_DELTAUPDATES
+    if (!cbServos) {
+        // Nothing changed, so there is no move to start
+        _cbSaved += _cbFrame;
+        _cbFrame = 0;
+        return;
+    }
+#endif
+#ifdef OPT_SSC_MOVESYNC
+    _bMoveSync = MOVESYNC_MOVING;   // a "Q" still out is about the last move
+    _ulMoveEnd = millis() + wMoveTime;
+#endif
+    FrameSend();
+}
 
-    g_InputController.AllowControllerInterrupts(true);    
-
+#ifdef OPT_ADAPTIVE_MOVETIME
+//--------------------------------------------------------------------
+//[WMinMoveTime] The largest pulse change of the frame at cSERVO_MAXSPEED, rounded
+//         up.  A degree is 10000/cPwmDiv us of pulse.
+//--------------------------------------------------------------------
+word ServoDriver::WMinMoveTime(void)
+{
+    if (_wMaxDelta == 0xffff)
+        return 0xffff;
+    return ((unsigned long)_wMaxDelta * cPwmDiv + (cSERVO_MAXSPEED*10L - 1)) / (cSERVO_MAXSPEED*10L);
 }
+#endif
 
 //--------------------------------------------------------------------
 //[FREE SERVOS] Frees all the servos
 //--------------------------------------------------------------------
 void ServoDriver::FreeServos(void)
 {
-    g_InputController.AllowControllerInterrupts(false);    // If on xbee on hserial tell hserial to not processess...
-    for (byte LegIndex = 0; LegIndex < 32; LegIndex++) {
-        SSCSerial.print("#");
-        SSCSerial.print(LegIndex, DEC);
-        SSCSerial.print("P0");
+    byte *pb = _pbFrame;
+    for (byte LegIndex = 0; LegIndex < SSC_NUMCHANNELS; LegIndex++) {
+        *pb++ = '#';
+        pb = SSCFormatDec(pb, LegIndex);
+        *pb++ = 'P';
+        *pb++ = '0';
     }
-    SSCSerial.print("T200\r");
-    g_InputController.AllowControllerInterrupts(true);    
+    *pb++ = 'T';
+    *pb++ = '2';
+    *pb++ = '0';
+    *pb++ = '0';
+    *pb++ = '\r';
+    _cbFrame = pb - _pbFrame;
+    FrameSend();
+    InvalidateShadow();
 }
 
 
@@ -419,10 +819,11 @@ void ServoDriver::FreeServos(void)
 #ifdef OPT_SSC_FORWARDER
 void  ServoDriver::SSCForwarder(void) 
 {
+    TxFlush();
     MSound(SOUND_PIN, 1, 1000, 2000);  //sound SOUND_PIN, [50\4000]
     delay(2000);
     int sChar;
-    int sPrevChar;
+    int sPrevChar = 0;
     DBGSerial.println("SSC Forwarder mode - Enter $<cr> to exit");
     
     while(digitalRead(PS2_CMD)) {
@@ -438,6 +839,7 @@ void  ServoDriver::SSCForwarder(void)
             DBGSerial.write(sChar & 0xff);
         }
     }
+    InvalidateShadow();     // whatever was typed may have moved the servos
     DBGSerial.println("Exited SSC Forwarder mode");
 }
 #endif // OPT_SSC_FORWARDER
@@ -446,31 +848,132 @@ void  ServoDriver::SSCForwarder(void)
 
 
 //==============================================================================
-// Quick and dirty helper function to read so many bytes in from the SSC with a timeout and an end of character marker...
+//[SSCQueryStart] Sends off a query, the caller prints the command right after.  The
+//         reply is complete after cbReply bytes or the wEOL byte, or when nothing came
+//         for wTimeoutMS.  Returns false if there is a query out already.
+//==============================================================================
+boolean ServoDriver::SSCQueryStart(byte bFor, byte cbReply, word wEOL, word wTimeoutMS)
+{
+    if (_bQState != SSCQ_IDLE)
+        return false;
+    TxFlush();
+    while (SSCSerial.available())
+        SSCSerial.read();           // nothing before our reply belongs to us
+    _bQFor = bFor;
+    _cbQWant = min(cbReply, SSC_QUERYSIZE);
+    _cbQReply = 0;
+    _wQEOL = wEOL;
+    _ulQTimeout = wTimeoutMS * 1000UL;
+    _ulQTime = micros();
+    _bQState = SSCQ_PENDING;
+    return true;
+}
+
+//==============================================================================
+//[SSCQueryPoll] Moves what came in of the reply out of the receive ring of the
+//         serial driver, returns the SSCQ_xxx state of the query
 //==============================================================================
-int SSCRead (byte* pb, int cb, word wTimeout, word wEOL)
+byte ServoDriver::SSCQueryPoll(void)
 {
     int ich;
-    byte* pbIn = pb;
-    unsigned long ulTimeLastChar = micros();
-    while (cb) {
-        while (!SSCSerial.available()) {
-            // check for timeout
-            if ((word)(micros()-ulTimeLastChar) > wTimeout) {
-                return (int)(pb-pbIn);
-            }    
+    
+    if (_bQState != SSCQ_PENDING)
+        return _bQState;
+    while ((ich = SSCSerial.read()) != -1) {
+        _abQReply[_cbQReply++] = (byte)ich;
+        _ulQTime = micros();        // update to say we received something
+        if ((_cbQReply == _cbQWant) || ((word)ich == _wQEOL)) {
+            _bQState = SSCQ_DONE;
+            break;
         }
-        ich = SSCSerial.read();
-        *pb++ = (byte)ich;
-        cb--;
+    }
+    if ((_bQState == SSCQ_PENDING) && ((micros() - _ulQTime) > _ulQTimeout))
+        _bQState = SSCQ_TIMEOUT;
+#ifdef OPT_SSC_MOVESYNC
+    if ((_bQState != SSCQ_PENDING) && (_bQFor == SSCQFOR_MOVE))
+        MoveQueryDone();            // ours, whoever polls
+#endif
+    return _bQState;
+}
+
+//==============================================================================
+//[SSCQueryWait] Waits until the reply of the query that is out is in or has timed
+//         out.  SoftwareSerial keeps the interrupts off while it sends, so nothing
+//         may go to the SSC-32 while a reply comes back.  The reply is left for
+//         whoever sent the query.
+//==============================================================================
+void ServoDriver::SSCQueryWait(void)
+{
+    while (SSCQueryPoll() == SSCQ_PENDING)
+        delayMicroseconds(100);
+}
 
-        if ((word)ich == wEOL)
-            break;    // we matched so get out of here.
-        ulTimeLastChar = micros();    // update to say we received something
+//==============================================================================
+//[SSCQueryEnd] Frees the query slot when the reply has been used, or drops the
+//         query that is out.  A late reply is thrown away by the next query.
+//==============================================================================
+void ServoDriver::SSCQueryEnd(void)
+{
+    _bQState = SSCQ_IDLE;
+    _bQFor = SSCQFOR_NONE;
+}
+
+#ifdef OPT_SSC_MOVESYNC
+//==============================================================================
+//[FMoveDone] From the planned end of the move on, asks the SSC-32 with "Q" every
+//         cSSC_MOVEQINTERVAL ms until it answers "." (all servos there) instead of "+".
+//         The move starts when the frame is in, so it ends after the planned time by
+//         the time the frame took on the wire; the SSC-32 never ends it sooner.
+//==============================================================================
+boolean ServoDriver::FMoveDone(void)
+{
+    long    lLeft;
+    
+    SSCQueryPoll();
+    if ((_bMoveSync == MOVESYNC_QUERY) && (_bQFor != SSCQFOR_MOVE))
+        _bMoveSync = MOVESYNC_MOVING;   // the query was dropped
+    if (_bMoveSync == MOVESYNC_DONE)
+        return true;
+    lLeft = (long)(_ulMoveEnd - millis());
+    if (cSSC_MOVELEAD && (lLeft <= cSSC_MOVELEAD)) {
+        _bMoveSync = MOVESYNC_DONE;
+        return true;
+    }
+    if ((_bMoveSync != MOVESYNC_MOVING) || (lLeft > 0))
+        return false;
+
+    TxService();
+#ifdef OPT_SSC_ASYNCTX
+#ifdef SSC_TIMERTX
+    if (TIMSK1 & _BV(OCIE1A))
+        return false;               // frame still going out, "Q" would wait for it
+#else
+    if (s_cbTx)
+        return false;
+#endif
+#endif
+    if (((millis() - _ulMoveQTime) >= cSSC_MOVEQINTERVAL) && SSCQueryStart(SSCQFOR_MOVE, 1, SSC_NOEOL, 5)) {
+        SSCSerial.print("Q\r");
+        _bMoveSync = MOVESYNC_QUERY;
     }
+    return false;
+}
 
-    return (int)(pb-pbIn);
+//==============================================================================
+//[MoveQueryDone] Takes the reply to "Q", called by SSCQueryPoll
+//==============================================================================
+void ServoDriver::MoveQueryDone(void)
+{
+    if (_bMoveSync == MOVESYNC_QUERY) {
+        if (_bQState == SSCQ_TIMEOUT)
+            _bMoveSync = MOVESYNC_NOQ;
+        else
+            _bMoveSync = (_abQReply[0] == '.')? MOVESYNC_DONE : MOVESYNC_MOVING;
+    }
+    _ulMoveQTime = millis();
+    SSCQueryEnd();
 }
+#endif
 
 //==============================================================================
 //	FindServoOffsets - Find the zero points for each of our servos... 
@@ -489,8 +992,7 @@ void ServoDriver::FindServoOffsets()
     static char *apszLegs[] = {"RR","RM","RF", "LR", "LM", "LF"};  // Leg Order
     static char *apszLJoints[] = {" Coxa", " Femur", " Tibia", " tArs"}; // which joint on the leg...
 
-    byte szTemp[5];
-    byte cbRead;
+    byte iRead;             // next servo to read the offset register of
 
     int data;
     short sSN ; 			// which servo number
@@ -498,6 +1000,12 @@ void ServoDriver::FindServoOffsets()
     boolean fExit = false;	// when to exit
     int ich;
     
+#ifdef OPT_GPPLAYER
+    GPCancel();
+#endif
+    SSCQueryWait();
+    SSCQueryEnd();          // we have the SSC-32 to ourselves now
+    TxFlush();
     if (CheckVoltage()) {
         // Voltage is low... 
         Serial.println("Low Voltage: fix or hit $ to abort");
@@ -515,18 +1023,11 @@ void ServoDriver::FindServoOffsets()
       abSSCServoNum[sSN*NUMSERVOSPERLEG + 3] = pgm_read_byte(&cTarsPin[sSN]);
 #endif
     }
-    // now lets loop through and get information and set servos to 1500
+    // now lets set servos to 1500, the offsets are read in below
     for (sSN=0; sSN < 6*NUMSERVOSPERLEG; sSN++ ) {
       asOffsets[sSN] = 0;       
       asOffsetsRead[sSN] = 0; 
       
-      SSCSerial.print("R");
-      SSCSerial.println(32+abSSCServoNum[sSN], DEC);
-      // now read in the current value...  Maybe should use atoi...
-      cbRead = SSCRead((byte*)szTemp, sizeof(szTemp), 10000, 13);
-      if (cbRead > 0)
-        asOffsetsRead[sSN] = atoi((const char *)szTemp);
-
       SSCSerial.print("#");
       SSCSerial.print(abSSCServoNum[sSN], DEC);
       SSCSerial.println("P1500");
@@ -537,8 +1038,25 @@ void ServoDriver::FindServoOffsets()
     Serial.println("    0-5 Chooses a leg, C-Coxa, F-Femur, T-Tibia");
 
   sSN = true;
-    while(!fExit) {
-        if (fNew) {
+    iRead = 0;
+    while(!fExit || (iRead < 6*NUMSERVOSPERLEG)) {
+        // Read the offset registers one query at a time while we go on
+        if (iRead < 6*NUMSERVOSPERLEG) {
+            byte bQ = SSCQueryPoll();
+            if (bQ == SSCQ_IDLE) {
+                SSCQueryStart(SSCQFOR_REG, 5, 13, 10);
+                SSCSerial.print("R");
+                SSCSerial.println(32+abSSCServoNum[iRead], DEC);
+            } else if (bQ != SSCQ_PENDING) {
+                _abQReply[_cbQReply] = 0;
+                asOffsetsRead[iRead++] = atoi((const char *)_abQReply);
+                SSCQueryEnd();
+            }
+        }
+        if (fExit)
+            continue;       // only the reads left to finish
+        
+        if (fNew && (sSN < iRead)) {
             Serial.print("Servo: ");
             Serial.print(apszLegs[sSN/NUMSERVOSPERLEG]);
             Serial.print(apszLJoints[sSN%NUMSERVOSPERLEG]);
@@ -547,6 +1065,7 @@ void ServoDriver::FindServoOffsets()
             Serial.println(")");
 
 	    // Now lets wiggle the servo
+            SSCQueryWait();     // not over the reply of the register read
             SSCSerial.print("#");
             SSCSerial.print(abSSCServoNum[sSN], DEC);
             SSCSerial.print("P");
@@ -587,6 +1106,7 @@ void ServoDriver::FindServoOffsets()
 		Serial.print("    ");
                 Serial.println(asOffsetsRead[sSN]+asOffsets[sSN], DEC);
                 
+                SSCQueryWait();
                 SSCSerial.print("#");
                 SSCSerial.print(abSSCServoNum[sSN], DEC);
                 SSCSerial.print("P");